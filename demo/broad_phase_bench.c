@@ -0,0 +1,173 @@
+// Times each broad phase against testing every pair of bodies, on a scene
+// laid out like a scrolling level: many small bodies, a few large ones and
+// one wide background, all drifting left. This program has its own main(),
+// so link it with the library but without emscripten.c, then run
+//   broad_phase_bench [bodies] [ticks]
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "body.h"
+#include "broad_phase.h"
+#include "list.h"
+#include "scene.h"
+#include "vector.h"
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 200;
+const double DT = 1.0 / 60;
+const unsigned SEED = 1;
+
+const vector_t LEVEL_SIZE = {20000, 600};
+const double SMALL_SIZE = 12;
+const double MEDIUM_SIZE = 40;
+const double LARGE_SIZE = 400;
+// every this many bodies is medium, and every this many is large
+const size_t MEDIUM_EVERY = 5;
+const size_t LARGE_EVERY = 50;
+const vector_t BACKGROUND_SIZE = {2125, 800};
+const double SCROLL_SPEED = 100;
+// every this many ticks, this many bodies are replaced with new ones
+const size_t CHURN_EVERY = 10;
+const size_t CHURN_BODIES = 20;
+const rgb_color_t BODY_COLOR = {0, 0, 0};
+
+/**
+ * The results of running the benchmark with one broad phase.
+ */
+typedef struct {
+  double find_pairs_seconds;
+  double tick_seconds;
+  // the pairs reported, and how many of them have overlapping boxes
+  size_t reported;
+  size_t overlapping;
+} bench_result_t;
+
+/**
+ * Gets the current time in seconds from an arbitrary start.
+ */
+double bench_now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/**
+ * Makes a rectangle with its bottom left corner at a point.
+ */
+list_t *bench_rectangle(vector_t corner, vector_t size) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {corner,
+                        {corner.x + size.x, corner.y},
+                        {corner.x + size.x, corner.y + size.y},
+                        {corner.x, corner.y + size.y}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex);
+    *vertex = corners[i];
+    list_add(shape, vertex);
+  }
+  return shape;
+}
+
+/**
+ * Adds a square of the given size at a random place in the level.
+ */
+void bench_add_body(scene_t *scene, double size) {
+  vector_t corner = {LEVEL_SIZE.x * rand() / RAND_MAX,
+                     LEVEL_SIZE.y * rand() / RAND_MAX};
+  body_t *body = body_init(bench_rectangle(corner, (vector_t){size, size}),
+                           1, BODY_COLOR, GOOMBA);
+  body_set_velocity(body, (vector_t){-SCROLL_SPEED + rand() % 7 - 3,
+                                     rand() % 3 - 1});
+  scene_add_body(scene, body);
+}
+
+/**
+ * Counts a pair found by the broad phase.
+ */
+void bench_count_pair(body_t *body1, body_t *body2, void *aux) {
+  bench_result_t *result = aux;
+  result->reported++;
+  if (aabb_overlap(body_get_aabb(body1), body_get_aabb(body2))) {
+    result->overlapping++;
+  }
+}
+
+/**
+ * Runs the same scene with a broad phase, timing scene_find_pairs() and
+ * scene_tick() (which updates the broad phase) separately.
+ */
+bench_result_t bench_run(broad_phase_kind_t kind, size_t bodies,
+                         size_t ticks) {
+  srand(SEED);
+  scene_t *scene = scene_init(LEVEL_SIZE.x, LEVEL_SIZE.y);
+  scene_set_broad_phase(scene, kind);
+  body_t *background =
+      body_init(bench_rectangle(VEC_ZERO, BACKGROUND_SIZE), 1, BODY_COLOR,
+                BACKGROUND);
+  scene_add_body(scene, background);
+  for (size_t i = 1; i < bodies; i++) {
+    double size = i % LARGE_EVERY == 0    ? LARGE_SIZE
+                  : i % MEDIUM_EVERY == 0 ? MEDIUM_SIZE
+                                          : SMALL_SIZE;
+    bench_add_body(scene, size);
+  }
+
+  bench_result_t result = {0, 0, 0, 0};
+  for (size_t tick = 0; tick < ticks; tick++) {
+    double start = bench_now();
+    scene_find_pairs(scene, bench_count_pair, &result);
+    double found = bench_now();
+    if (tick % CHURN_EVERY == 0) {
+      // replace some small bodies, never the background
+      for (size_t i = 0; i < CHURN_BODIES; i++) {
+        size_t index = 1 + rand() % (scene_bodies(scene) - 1);
+        body_remove(scene_get_body(scene, index));
+        bench_add_body(scene, SMALL_SIZE);
+      }
+    }
+    double churned = bench_now();
+    scene_tick(scene, DT);
+    double ticked = bench_now();
+    result.find_pairs_seconds += found - start;
+    result.tick_seconds += ticked - churned;
+  }
+  scene_free(scene);
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  size_t bodies = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_BODIES;
+  size_t ticks = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_TICKS;
+  if (bodies < 2 || ticks == 0) {
+    fprintf(stderr, "usage: %s [bodies >= 2] [ticks >= 1]\n", argv[0]);
+    return 1;
+  }
+
+  const char *names[] = {"all pairs", "aabb tree", "sweep and prune"};
+  broad_phase_kind_t kinds[] = {BROAD_PHASE_NONE, BROAD_PHASE_AABB_TREE,
+                                BROAD_PHASE_SWEEP_AND_PRUNE};
+  printf("%zu bodies, %zu ticks\n", bodies, ticks);
+  printf("%-16s %14s %14s %12s %12s\n", "broad phase", "find ms/tick",
+         "tick ms/tick", "pairs/tick", "overlapping");
+  size_t expected = 0;
+  int status = 0;
+  for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    bench_result_t result = bench_run(kinds[i], bodies, ticks);
+    printf("%-16s %14.3f %14.3f %12.1f %12.1f\n", names[i],
+           1e3 * result.find_pairs_seconds / ticks,
+           1e3 * result.tick_seconds / ticks, (double)result.reported / ticks,
+           (double)result.overlapping / ticks);
+    // every broad phase must find every pair whose boxes overlap
+    if (kinds[i] == BROAD_PHASE_NONE) {
+      expected = result.overlapping;
+    } else if (result.overlapping != expected) {
+      printf("%s found %zu overlapping pairs instead of %zu\n", names[i],
+             result.overlapping, expected);
+      status = 1;
+    }
+  }
+  return status;
+}
@@ -5,6 +5,7 @@
 
 #include "block.h"
 #include "body.h"
+#include "character.h"
 #include "collision.h"
 #include "forces.h"
 #include "level.h"
@@ -25,12 +26,10 @@ const double HEART_SIZE = 50;
 const vector_t PORTAL_DISPLACEMENT = {300, 100};
 
 const double GRAVITY = 250;
-const double GROUND_PADDING = 1.5;
-const double WALL_PADDING = 3;
 const int COIN_PLAYER_DIST = 100;
 const double MAGNET_STRENGTH = 100.0;
-const double PROJECTILE_VELOCITY = 100;
 const double OBSTACLE_MASS = 10;
+const double GROUND_PROBE_DISTANCE = 2;
 const size_t NUM_LEVEL_BUTTON = 1;
 
 // Text Constants
@@ -132,15 +131,15 @@ body_t *jump_block(body_t *player);
 void unpause(state_t *state);
 void music_init(state_t *state);
 void music_free(state_t *state);
-void ground_handler(body_t *player, body_t *ground, vector_t axis, void *state);
-void wall_handler(body_t *player, body_t *wall, vector_t axis, void *state);
 void gen_hearts(scene_t *scene);
 void lower_health(body_t *player, body_t *enemy, vector_t axis, void *state);
+void projectile_handler(body_t *player, vector_t position, void *state);
 void magnet_handler(body_t *player, body_t *magnet, vector_t axis,
                     state_t *state);
 void coin_collector(body_t *player, body_t *coin, vector_t axis, void *aux);
-void load_force(state_t *state, body_t *body);
-void portal_handler(body_t *player, body_t *portal, vector_t axis, void *state);
+void load_collision_handlers(state_t *state);
+void portal_handler(body_t *player, body_t *portal, contact_event_t event,
+                    vector_t axis, void *scene);
 
 typedef void (*button_handler_t)(state_t *state);
 typedef void (*button_handler_with_idx_t)(state_t *state, int idx);
@@ -167,6 +166,7 @@ struct button_info {
 struct state {
   scene_t *scene;
   body_t *player;
+  character_t *character;
   active_t active;
   scene_t *paused_scene;
   list_t *buttons;
@@ -211,6 +211,9 @@ void gen_hearts(scene_t *scene) {
   body_set_centroid(heart_one, (vector_t){SCENE_SIZE.x - 6 * HEART_SIZE,
                                           SCENE_SIZE.y - 2 * HEART_SIZE});
 
+  body_set_collision_filter(heart_one, 0, 0);
+  body_set_collision_filter(heart_two, 0, 0);
+  body_set_collision_filter(heart_three, 0, 0);
   scene_add_body(scene, heart_one);
   scene_add_body(scene, heart_two);
   scene_add_body(scene, heart_three);
@@ -219,6 +222,7 @@ void gen_hearts(scene_t *scene) {
 body_t *gen_button(vector_t size, vector_t pos, const char *sprite_path,
                    button_handler_t handler) {
   body_t *button = sprite_init(INFINITY, OTHER, sprite_path, size.x, size.y);
+  body_set_collision_filter(button, 0, 0);
   body_set_info(button, handler);
   body_set_centroid(button, pos);
   return button;
@@ -228,6 +232,7 @@ body_t *gen_button_with_idx(vector_t size, vector_t pos,
                             const char *sprite_path,
                             button_handler_with_idx_t handler, int idx) {
   body_t *button = sprite_init(INFINITY, OTHER, sprite_path, size.x, size.y);
+  body_set_collision_filter(button, 0, 0);
   button_info_t *info = malloc(sizeof(*info));
   info->handler = handler;
   info->idx = idx;
@@ -589,6 +594,7 @@ void menu_init(state_t *state) {
 void level1_init(state_t *state) {
   clear_scene(state);
   state->scene = scene_init(SCENE_SIZE.x, SCENE_SIZE.y);
+  scene_set_broad_phase(state->scene, BROAD_PHASE_SWEEP_AND_PRUNE);
   state->level = load_level(state->scene, "/assets/levels/level_1.txt");
   state->absolute_origin = VEC_ZERO;
 
@@ -614,10 +620,12 @@ void level1_init(state_t *state) {
   body_set_info(player, player_info);
 
   // Add forces and collisions
-  create_gravity(state->scene, GRAVITY, player);
-  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-    load_force(state, scene_get_body(state->scene, i));
-  }
+  scene_add_force_field(state->scene,
+                        force_field_gravity((vector_t){0, -GRAVITY},
+                                            CATEGORY_PLAYER));
+  state->character = character_init(player, CATEGORY_TERRAIN);
+  scene_add_character(state->scene, state->character);
+  load_collision_handlers(state);
 
   // Adds health indicators
   gen_hearts(state->scene);
@@ -668,63 +676,60 @@ void game_over(state_t *state) {
   list_add(state->buttons, button);
 }
 
-void load_force(state_t *state, body_t *body) {
-  body_t *player = state->player;
+/**
+ * Registers what happens when the player runs into each type of block.
+ * Called once per level; blocks rendered later are covered automatically.
+ */
+void load_collision_handlers(state_t *state) {
   scene_t *scene = state->scene;
-  body_type_t type = body_get_type(body);
-  if (type == MAGNET) {
-    create_collision(scene, player, body, (collision_handler_t)magnet_handler,
-                     NULL, NULL);
-  }
-  if (type == FIREBALL || type == GOOMBA || type == THOMP || type == PLANT ||
-      type == SPACESHIP) {
-    create_collision(scene, player, body, (collision_handler_t)lower_health,
-                     state, NULL);
-  }
-  if (type == GROUND) {
-    create_collision(scene, player, body, (collision_handler_t)ground_handler,
-                     state, NULL);
-  }
-  if (type == WALL) {
-    create_collision(scene, player, body, (collision_handler_t)wall_handler,
-                     NULL, NULL);
-  }
-  if (type == COIN) {
-    create_collision(scene, player, body, (collision_handler_t)coin_collector,
-                     NULL, NULL);
-  }
-  if (type == PORTAL) {
-    create_collision(scene, player, body, (collision_handler_t)portal_handler,
-                     NULL, NULL);
-  }
+  scene_add_collision_handler(scene, PLAYER, MAGNET,
+                              (collision_handler_t)magnet_handler, state, NULL);
+  body_type_t enemies[] = {FIREBALL, GOOMBA, THOMP, PLANT, SPACESHIP};
+  for (size_t i = 0; i < sizeof(enemies) / sizeof(enemies[0]); i++) {
+    scene_add_collision_handler(scene, PLAYER, enemies[i], lower_health, state,
+                                NULL);
+  }
+  scene_add_collision_handler(scene, PLAYER, COIN, coin_collector, NULL, NULL);
+  projectile_pool_t *balls = scene_get_projectiles(scene, BALL);
+  if (balls != NULL) {
+    projectile_pool_set_targets(balls, CATEGORY_PLAYER, projectile_handler,
+                                state, CATEGORY_TERRAIN);
+  }
+  scene_add_contact_handler(scene, PLAYER, PORTAL, portal_handler, scene,
+                            NULL);
 }
 
-/** Collision handler to handle magnet powerup */
-void portal_handler(body_t *player, body_t *portal, vector_t axis,
-                    void *state) {
+/** Contact handler to teleport the player once per portal entry */
+void portal_handler(body_t *player, body_t *portal, contact_event_t event,
+                    vector_t axis, void *scene) {
+  if (event != CONTACT_BEGIN) {
+    return;
+  }
   vector_t centroid = body_get_centroid(player);
-  body_set_centroid(player, vec_add(centroid, PORTAL_DISPLACEMENT));
+  scene_set_centroid(scene, player, vec_add(centroid, PORTAL_DISPLACEMENT));
+}
+
+/** Projectile handler to hurt the player when an enemy's shot hits */
+void projectile_handler(body_t *player, vector_t position, void *state) {
+  lower_health(player, NULL, VEC_ZERO, state);
 }
 
 /** Collision handler to handle magnet powerup */
 void magnet_handler(body_t *player, body_t *magnet, vector_t axis,
                     state_t *state) {
-  for (size_t i = 0; i < scene_bodies(((state_t *)state)->scene); i++) {
-    body_t *body = scene_get_body(((state_t *)state)->scene, i);
-    body_type_t type = body_get_type(body);
-    if (type == COIN) {
-      double dist = get_distance(player, body);
-      if (dist < 5.0) {
-        return;
-      }
-      if (get_distance(player, body) <= COIN_PLAYER_DIST) {
-        double angle = get_angle(player, body);
-        vector_t v = (vector_t){.x = MAGNET_STRENGTH * cos(angle),
-                                .y = MAGNET_STRENGTH * sin(angle)};
-        body_add_force(body, v);
-      }
+  vector_t center = body_get_centroid(player);
+  list_t *coins =
+      scene_query_radius(state->scene, center, COIN_PLAYER_DIST, COIN);
+  for (size_t i = 0; i < list_size(coins); i++) {
+    scene_neighbor_t *coin = list_get(coins, i);
+    if (coin->distance_squared < 5.0 * 5.0) {
+      break;
     }
+    vector_t offset = vec_subtract(body_get_centroid(coin->body), center);
+    double dist = sqrt(coin->distance_squared);
+    body_add_force(coin->body, vec_multiply(MAGNET_STRENGTH / dist, offset));
   }
+  list_free(coins);
 }
 
 /** Collision handler to colllect coins */
@@ -744,14 +749,9 @@ void lower_health(body_t *player, body_t *enemy, vector_t axis, void *state) {
   }
   body_info_t *info = body_get_info(player);
   if (info->health == 1) {
-    for (size_t i = 0; i < scene_bodies(((state_t *)state)->scene); i++) {
-      state1->ticks_since_damage = 0;
-      body_t *body = scene_get_body(((state_t *)state)->scene, i);
-      body_type_t type = body_get_type(body);
-      if (type == HEART1) {
-        body_remove(body);
-        break;
-      }
+    state1->ticks_since_damage = 0;
+    if (scene_bodies_of_type(state1->scene, HEART1) > 0) {
+      body_remove(scene_get_body_of_type(state1->scene, HEART1, 0));
     }
     info->health = info->health + 1;
     body_set_info(player, info);
@@ -760,13 +760,8 @@ void lower_health(body_t *player, body_t *enemy, vector_t axis, void *state) {
 
   if (info->health == 2) {
     state1->ticks_since_damage = 0;
-    for (size_t i = 0; i < scene_bodies(((state_t *)state)->scene); i++) {
-      body_t *body = scene_get_body(((state_t *)state)->scene, i);
-      body_type_t type = body_get_type(body);
-      if (type == HEART2) {
-        body_remove(body);
-        break;
-      }
+    if (scene_bodies_of_type(state1->scene, HEART2) > 0) {
+      body_remove(scene_get_body_of_type(state1->scene, HEART2, 0));
     }
     info->health = info->health + 1;
     body_set_info(player, info);
@@ -775,13 +770,8 @@ void lower_health(body_t *player, body_t *enemy, vector_t axis, void *state) {
 
   if (info->health == 3) {
     state1->ticks_since_damage = 0;
-    for (size_t i = 0; i < scene_bodies(((state_t *)state)->scene); i++) {
-      body_t *body = scene_get_body(((state_t *)state)->scene, i);
-      body_type_t type = body_get_type(body);
-      if (type == HEART3) {
-        body_remove(body);
-        break;
-      }
+    if (scene_bodies_of_type(state1->scene, HEART3) > 0) {
+      body_remove(scene_get_body_of_type(state1->scene, HEART3, 0));
     }
     info->health = info->health + 1;
     body_set_info(player, info);
@@ -793,38 +783,6 @@ void lower_health(body_t *player, body_t *enemy, vector_t axis, void *state) {
   }
 }
 
-/** Collision handler to reset jump of player upon collision with obstacle and
- * keep player above ground*/
-void ground_handler(body_t *player, body_t *ground, vector_t axis,
-                    void *state) {
-  body_info_t *info = body_get_info(player);
-  info->jumps = 2;
-
-  // Stop player from sinking into ground
-  vector_t centroid = body_get_centroid(player);
-  vector_t velocity = body_get_velocity(player);
-  centroid.y = body_get_centroid(ground).y + BLOCK_WIDTH + GROUND_PADDING;
-  velocity.y = 0;
-  body_set_centroid(player, centroid);
-  body_set_velocity(player, velocity);
-}
-
-/** Keeps player out of walls. */
-void wall_handler(body_t *player, body_t *wall, vector_t axis, void *state) {
-  vector_t wall_center = body_get_centroid(wall);
-  vector_t player_center = body_get_centroid(player);
-  vector_t offset = {BLOCK_WIDTH + WALL_PADDING, 0};
-  vector_t v = body_get_velocity(player);
-  if (wall_center.x - WALL_PADDING - BLOCK_WIDTH < player_center.x &&
-      wall_center.x - WALL_PADDING > player_center.x) {
-    body_set_velocity(player, (vector_t){-SCROLL_SPEED, v.y});
-    body_set_centroid(player, vec_subtract(wall_center, offset));
-  } else if (wall_center.x + BLOCK_WIDTH + WALL_PADDING > player_center.x) {
-    body_set_velocity(player, (vector_t){-SCROLL_SPEED, v.y});
-    body_set_centroid(player, vec_add(wall_center, offset));
-  }
-}
-
 void on_key_1(void *state, char key, key_event_type_t type, double held_time,
               vector_t click) {
   state_t *state1 = (state_t *)state;
@@ -920,34 +878,21 @@ void on_key_1(void *state, char key, key_event_type_t type, double held_time,
   }
 }
 
-body_t *generate_proj(body_t *start) {
-  body_t *bullet = block_init(BALL);
-  body_set_centroid(bullet, body_get_centroid(start));
-  body_set_velocity(bullet, (vector_t){0, -1 * PROJECTILE_VELOCITY});
-  block_add_proj(start, bullet);
-  return bullet;
-}
-
 void obstacle_handler(state_t *state) {
-  for (int i = 0; i < scene_bodies(state->scene); i++) {
-    body_t *body = scene_get_body(state->scene, i);
-    body_type_t type = body_get_type(body);
-    if (type == THOMP) {
-      // If block hits the ground
-      // Change velocity to go upwards again
-    } else if (type == GOOMBA) {
-      return;
-    } else if (type == SPACESHIP) {
-      if (block_get_time_since(body) > block_get_time(body)) {
-        block_set_time_since(body, 0.0);
-        vector_t curr_velocity = body_get_velocity(body);
-        body_set_velocity(body, vec_multiply(-1, curr_velocity));
-        body_t *bullet = generate_proj(body);
-        scene_add_body(state->scene, bullet);
-      } else if (block_get_time_since(body) > block_get_time(body)) {
-        body_t *bullet = generate_proj(body);
-        scene_add_body(state->scene, bullet);
+  for (size_t i = 0; i < scene_bodies_of_type(state->scene, THOMP); i++) {
+    body_t *body = scene_get_body_of_type(state->scene, THOMP, i);
+    // If block hits the ground
+    // Change velocity to go upwards again
+    vector_t v = body_get_velocity(body);
+    if (v.y < 0) {
+      vector_t bottom = {body_get_centroid(body).x, body_get_aabb(body).min.y};
+      list_t *hits = scene_raycast(state->scene, bottom,
+                                   (vector_t){0, -GROUND_PROBE_DISTANCE},
+                                   CATEGORY_TERRAIN);
+      if (list_size(hits) > 0) {
+        body_set_velocity(body, (vector_t){v.x, -v.y});
       }
+      list_free(hits);
     }
   }
 }
@@ -987,28 +932,19 @@ void emscripten_main(state_t *state) {
       render_info_t *render_info =
           render_column(state->scene, state->level, column_to_load,
                         SCROLL_SPEED, state->absolute_origin);
-      list_t *bodies = render_info->rendered;
-      for (size_t i = 0; i < list_size(bodies); i++) {
-        load_force(state, list_get(bodies, i));
-      }
       render_info_free(render_info);
       state->last_column_loaded = column_to_load;
     }
 
     scene_tick(state->scene, time_elapsed);
+    // Landing on the ground resets the double jump
+    if (character_is_grounded(state->character)) {
+      body_info_t *player_info = body_get_info(state->player);
+      player_info->jumps = 2;
+    }
     state->ticks_since_damage++;
     state->absolute_origin.x -= SCROLL_SPEED * time_elapsed;
 
-    // Increments time
-    for (int i = 0; i < scene_bodies(state->scene); i++) {
-      body_t *obstacle = scene_get_body(state->scene, i);
-      body_type_t type = body_get_type(obstacle);
-      if (type == GOOMBA || type == SPACESHIP || type == THOMP) {
-        block_set_time_since(obstacle,
-                             block_get_time_since(obstacle) + time_elapsed);
-      }
-    }
-
     // Handles obstacle movements
     obstacle_handler(state);
   }
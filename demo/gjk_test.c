@@ -0,0 +1,143 @@
+// Cross-checks the GJK/EPA narrow phase against SAT on random pairs of
+// convex polygons, circles and capsules: both must agree on whether each
+// pair collides and, when it does, on how deep. This program has its own
+// main(), so link it with the library but without emscripten.c, then run
+//   gjk_test [pairs]
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "body.h"
+#include "collision.h"
+#include "list.h"
+#include "vector.h"
+
+const size_t DEFAULT_PAIRS = 200000;
+const unsigned SEED = 1;
+const size_t MIN_VERTICES = 3;
+const size_t MAX_VERTICES = 64;
+const double MIN_RADIUS = 1;
+const double MAX_RADIUS = 5;
+// the second shape's centroid is placed this far from the first's in x and y
+const double MAX_OFFSET = 7;
+const double CIRCLE_RADIUS = 1.5;
+const vector_t CAPSULE_START = {-1, 0.5};
+const vector_t CAPSULE_END = {1, -0.3};
+const double CAPSULE_RADIUS = 0.7;
+// pairs closer than this to touching may be reported either way
+const double TOUCH_TOLERANCE = 1e-6;
+// how far apart the two depths of a colliding pair may be
+const double DEPTH_TOLERANCE = 1e-6;
+const rgb_color_t SHAPE_COLOR = {0, 0, 0};
+
+/**
+ * The kinds of pairs checked, picked at random for each pair.
+ */
+typedef enum {
+  PAIR_POLYGONS,
+  PAIR_POLYGON_CIRCLE,
+  PAIR_POLYGON_CAPSULE,
+  PAIR_CIRCLE_CAPSULE,
+  PAIR_KIND_COUNT
+} pair_kind_t;
+
+/**
+ * Gets a random number between min and max.
+ */
+double random_between(double min, double max) {
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+/**
+ * Compares angles, for sorting the vertices of a random polygon.
+ */
+int compare_angles(const void *angle1, const void *angle2) {
+  double difference = *(const double *)angle1 - *(const double *)angle2;
+  return (difference > 0) - (difference < 0);
+}
+
+/**
+ * Makes a convex polygon with vertices at random angles on a circle,
+ * in counterclockwise order.
+ */
+list_t *random_polygon(vector_t center, double radius, size_t size) {
+  double *angles = malloc(size * sizeof(double));
+  assert(angles);
+  for (size_t i = 0; i < size; i++) {
+    angles[i] = random_between(0, 2 * M_PI);
+  }
+  qsort(angles, size, sizeof(double), compare_angles);
+
+  list_t *polygon = list_init(size, free);
+  for (size_t i = 0; i < size; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex);
+    *vertex = vec_add(center, (vector_t){radius * cos(angles[i]),
+                                         radius * sin(angles[i])});
+    list_add(polygon, vertex);
+  }
+  free(angles);
+  return polygon;
+}
+
+/**
+ * Makes a body with a random polygon around a point.
+ */
+body_t *random_body(vector_t center) {
+  size_t size = MIN_VERTICES + rand() % (MAX_VERTICES - MIN_VERTICES + 1);
+  double radius = random_between(MIN_RADIUS, MAX_RADIUS);
+  return body_init(random_polygon(center, radius, size), 1, SHAPE_COLOR,
+                   OTHER);
+}
+
+int main(int argc, char *argv[]) {
+  size_t pairs = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_PAIRS;
+  srand(SEED);
+
+  size_t collided = 0;
+  size_t disagreements = 0;
+  double max_depth_error = 0;
+  for (size_t i = 0; i < pairs; i++) {
+    body_t *body1 = random_body(VEC_ZERO);
+    body_t *body2 =
+        random_body((vector_t){random_between(-MAX_OFFSET, MAX_OFFSET),
+                               random_between(-MAX_OFFSET, MAX_OFFSET)});
+    pair_kind_t kind = rand() % PAIR_KIND_COUNT;
+    if (kind == PAIR_POLYGON_CIRCLE) {
+      body_set_circle(body2, CIRCLE_RADIUS);
+    } else if (kind == PAIR_POLYGON_CAPSULE) {
+      body_set_capsule(body2, CAPSULE_START, CAPSULE_END, CAPSULE_RADIUS);
+    } else if (kind == PAIR_CIRCLE_CAPSULE) {
+      body_set_circle(body1, CIRCLE_RADIUS);
+      body_set_capsule(body2, CAPSULE_START, CAPSULE_END, CAPSULE_RADIUS);
+    }
+
+    collision_shape_t shape1 = body_get_collision_shape(body1);
+    collision_shape_t shape2 = body_get_collision_shape(body2);
+    collision_info_t sat = find_shape_collision(&shape1, &shape2);
+    collision_info_t gjk = find_shape_collision_gjk(&shape1, &shape2);
+    bool disagree = false;
+    if (sat.collided != gjk.collided) {
+      disagree = fabs(sat.da_overlap) > TOUCH_TOLERANCE;
+    } else if (sat.collided) {
+      collided++;
+      double error = fabs(sat.da_overlap - gjk.da_overlap);
+      max_depth_error = fmax(max_depth_error, error);
+      disagree = error > DEPTH_TOLERANCE;
+    }
+    if (disagree) {
+      disagreements++;
+      printf("pair %zu (kind %d): SAT %d depth %.9g, GJK %d depth %.9g\n", i,
+             kind, sat.collided, sat.da_overlap, gjk.collided,
+             gjk.da_overlap);
+    }
+    body_free(body1);
+    body_free(body2);
+  }
+
+  printf("%zu pairs, %zu colliding, max depth error %g, %zu disagreements\n",
+         pairs, collided, max_depth_error, disagreements);
+  return disagreements == 0 ? 0 : 1;
+}
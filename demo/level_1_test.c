@@ -209,12 +209,9 @@ void game_init(state_t *state) {
   scene_add_body(state->scene, bottom);
 
   // Add collsions
-  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-    body_t *body = scene_get_body(state->scene, i);
-    body_type_t type = body_get_type(body);
-    if (type == WALL) {
-      create_physics_collision(state->scene, ELASTICITY, state->player, body);
-    }
+  for (size_t i = 0; i < scene_bodies_of_type(state->scene, WALL); i++) {
+    body_t *body = scene_get_body_of_type(state->scene, WALL, i);
+    create_physics_collision(state->scene, ELASTICITY, state->player, body);
   }
 }
 
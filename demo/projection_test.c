@@ -0,0 +1,141 @@
+// Checks that the SIMD projection kernels of collision.c give exactly the
+// same extrema as the scalar kernel. This program has its own main(), so
+// link it with the library but without emscripten.c, e.g.
+//   gcc -O2 -Iinclude demo/projection_test.c library/collision.c ... -lm
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "collision.h"
+#include "vector.h"
+
+#ifdef __SSE2__
+#define HAVE_SSE2_KERNEL
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL
+#endif
+
+// every size up to this one is checked on every trial, which covers each
+// remainder of the 4- and 8-vertex loops
+const size_t SMALL_SIZE_MAX = 15;
+const size_t LARGE_SIZE_MAX = 1000;
+const size_t TRIALS = 2000;
+const double COORDINATE_RANGE = 1000;
+// how far into the array the vertices start, so unaligned loads are checked
+const size_t MAX_OFFSET = 3;
+const unsigned SEED = 1;
+
+// the kernels are internal to collision.c, so they are declared here
+typedef struct {
+  double min;
+  double max;
+} proj_extrema_t;
+
+proj_extrema_t project_scalar(const vector_t *vertices, size_t size,
+                              vector_t axis);
+#ifdef HAVE_SSE2_KERNEL
+proj_extrema_t project_sse2(const vector_t *vertices, size_t size,
+                            vector_t axis);
+#endif
+#ifdef HAVE_AVX2_KERNEL
+proj_extrema_t project_avx2(const vector_t *vertices, size_t size,
+                            vector_t axis);
+#endif
+
+/**
+ * Gets a random number between -range and range.
+ */
+double random_coordinate(double range) {
+  return range * (2.0 * rand() / RAND_MAX - 1);
+}
+
+/**
+ * Gets a random unit vector.
+ */
+vector_t random_axis(void) {
+  double angle = 2 * M_PI * rand() / RAND_MAX;
+  return (vector_t){cos(angle), sin(angle)};
+}
+
+/**
+ * Compares the result of a kernel with the scalar kernel's, printing the
+ * case if they differ.
+ */
+bool check_kernel(const char *name, proj_extrema_t expected,
+                  proj_extrema_t actual, size_t size, size_t offset) {
+  if (actual.min == expected.min && actual.max == expected.max) {
+    return true;
+  }
+  printf("%s differs for %zu vertices at offset %zu: "
+         "[%.17g, %.17g] instead of [%.17g, %.17g]\n",
+         name, size, offset, actual.min, actual.max, expected.min,
+         expected.max);
+  return false;
+}
+
+/**
+ * Runs every available kernel on one array and compares them.
+ * Returns the number of kernels that differ from the scalar kernel.
+ */
+size_t check_size(vector_t *vertices, size_t size, bool avx2) {
+  size_t offset = rand() % (MAX_OFFSET + 1);
+  for (size_t i = 0; i < size; i++) {
+    vertices[offset + i] = (vector_t){random_coordinate(COORDINATE_RANGE),
+                                      random_coordinate(COORDINATE_RANGE)};
+  }
+  vector_t axis = random_axis();
+  proj_extrema_t expected = project_scalar(vertices + offset, size, axis);
+  size_t failures = 0;
+#ifdef HAVE_SSE2_KERNEL
+  failures += !check_kernel("project_sse2", expected,
+                            project_sse2(vertices + offset, size, axis), size,
+                            offset);
+#endif
+#ifdef HAVE_AVX2_KERNEL
+  if (avx2) {
+    failures += !check_kernel("project_avx2", expected,
+                              project_avx2(vertices + offset, size, axis),
+                              size, offset);
+  }
+#else
+  (void)avx2;
+#endif
+  return failures;
+}
+
+int main(void) {
+  srand(SEED);
+  bool avx2 = false;
+#ifdef HAVE_AVX2_KERNEL
+  avx2 = __builtin_cpu_supports("avx2");
+#endif
+  vector_t *vertices =
+      malloc((LARGE_SIZE_MAX + MAX_OFFSET) * sizeof(vector_t));
+  assert(vertices);
+
+  size_t checks = 0;
+  size_t failures = 0;
+  for (size_t trial = 0; trial < TRIALS; trial++) {
+    for (size_t size = 0; size <= SMALL_SIZE_MAX; size++) {
+      failures += check_size(vertices, size, avx2);
+      checks++;
+    }
+    size_t size =
+        SMALL_SIZE_MAX + 1 + rand() % (LARGE_SIZE_MAX - SMALL_SIZE_MAX);
+    failures += check_size(vertices, size, avx2);
+    checks++;
+  }
+  free(vertices);
+
+  printf("%zu arrays checked (sse2: %s, avx2: %s), %zu mismatches\n", checks,
+#ifdef HAVE_SSE2_KERNEL
+         "yes",
+#else
+         "no",
+#endif
+         avx2 ? "yes" : "no", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+#ifndef __AABB_TREE_H__
+#define __AABB_TREE_H__
+
+#include "collision.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A dynamic bounding volume hierarchy of axis-aligned boxes.
+ * Each leaf (a "proxy") stores a fattened copy of the box it was given, so
+ * that an object which moves a little does not have to be reinserted.
+ * The tree is kept balanced with rotations, so inserting, removing and
+ * moving a proxy take O(log n) time.
+ */
+typedef struct aabb_tree aabb_tree_t;
+
+/**
+ * A function called for every proxy found by a query.
+ *
+ * @param proxy the proxy whose fat box overlaps the query
+ * @param data the data the proxy was inserted with
+ * @param aux the auxiliary value passed to the query
+ * @return whether to keep searching
+ */
+typedef bool (*aabb_query_t)(size_t proxy, void *data, void *aux);
+
+/**
+ * The value used for a missing proxy.
+ */
+extern const size_t AABB_TREE_NULL;
+
+/**
+ * Allocates an empty tree.
+ *
+ * @param margin how far each proxy's fat box extends past its real box
+ * @return the new tree
+ */
+aabb_tree_t *aabb_tree_init(double margin);
+
+/**
+ * Releases the memory used by a tree.
+ * The data stored in the proxies is not freed.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ */
+void aabb_tree_free(aabb_tree_t *tree);
+
+/**
+ * Adds a proxy to a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param aabb the box of the object
+ * @param data a value to associate with the proxy
+ * @return the new proxy, which stays valid until it is removed
+ */
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t aabb, void *data);
+
+/**
+ * Removes a proxy from a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy a proxy returned from aabb_tree_insert()
+ */
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Updates the box of a proxy.
+ * Does nothing if the new box still fits within the proxy's fat box.
+ * Otherwise, the proxy is reinserted with a new fat box, which is also
+ * extended in the direction of displacement to anticipate further motion.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy a proxy returned from aabb_tree_insert()
+ * @param aabb the new box of the object
+ * @param displacement how far the object is expected to move before it
+ *   should need reinserting
+ * @return whether the proxy was reinserted
+ */
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t aabb,
+                    vector_t displacement);
+
+/**
+ * Gets the fat box of a proxy.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy a proxy returned from aabb_tree_insert()
+ * @return the box stored in the tree, which contains the object's box
+ */
+aabb_t aabb_tree_get_fat_aabb(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Gets the data associated with a proxy.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy a proxy returned from aabb_tree_insert()
+ * @return the data passed to aabb_tree_insert()
+ */
+void *aabb_tree_get_data(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Finds every proxy whose fat box overlaps a box.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param aabb the box to search
+ * @param callback a function called on every proxy found,
+ *   which can stop the search by returning false
+ * @param aux an auxiliary value to pass to callback
+ */
+void aabb_tree_query(aabb_tree_t *tree, aabb_t aabb, aabb_query_t callback,
+                     void *aux);
+
+/**
+ * Finds every proxy whose fat box a line segment passes through, only
+ * descending into the subtrees whose boxes the segment crosses.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param origin where the segment starts
+ * @param translation the vector from the start of the segment to its end
+ * @param callback a function called on every proxy found,
+ *   which can stop the search by returning false
+ * @param aux an auxiliary value to pass to callback
+ */
+void aabb_tree_raycast(aabb_tree_t *tree, vector_t origin,
+                       vector_t translation, aabb_query_t callback, void *aux);
+
+/**
+ * Calls a function on every proxy in a tree, in no particular order.
+ * The callback may move proxies with aabb_tree_move(),
+ * but must not insert or remove any.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param callback a function called on every proxy,
+ *   which can stop the iteration by returning false
+ * @param aux an auxiliary value to pass to callback
+ */
+void aabb_tree_for_each(aabb_tree_t *tree, aabb_query_t callback, void *aux);
+
+/**
+ * Gets the height of a tree, i.e. the number of edges from the root to the
+ * deepest leaf. An empty tree has height 0.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @return the height of the tree
+ */
+size_t aabb_tree_height(aabb_tree_t *tree);
+
+#endif // #ifndef __AABB_TREE_H__
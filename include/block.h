@@ -7,10 +7,22 @@
 
 extern const double BLOCK_WIDTH;
 
+/**
+ * The collision categories block_init() puts blocks in.
+ * See body_set_collision_filter().
+ */
+extern const uint32_t CATEGORY_PLAYER;
+extern const uint32_t CATEGORY_TERRAIN;
+extern const uint32_t CATEGORY_ENEMY;
+extern const uint32_t CATEGORY_PICKUP;
+
 typedef struct obstacle_info obstacle_info_t;
 
 /**
  * Initializes a new block and returns the body
+ * Sets the block's collision filter from its type, so that only the player
+ * collides with other blocks. Pickups are made sensors and projectiles are
+ * made bullets.
  *
  * @param body_type the type of the block to be created
  * @return body_t* the body created from the initialization
@@ -1,12 +1,14 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include "collision.h"
 #include "color.h"
 #include "list.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_surface.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum {
   GROUND,
@@ -35,9 +37,20 @@ typedef enum {
   WATERBALL,
   CRAB,
   BULLET,
-  FLAG
+  FLAG,
+  BODY_TYPE_COUNT // the number of body types, not a type itself
 } body_type_t;
 
+/**
+ * The proxy of a body that is not in any broad phase.
+ */
+extern const size_t BODY_NO_PROXY;
+
+/**
+ * A collision mask that accepts every category.
+ */
+extern const uint32_t COLLISION_MASK_ALL;
+
 /**
  * A rigid body constrained to the plane.
  * Implemented as a polygon with uniform density.
@@ -101,6 +114,186 @@ void body_free(body_t *body);
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets the shape of a body prepared for collision checks.
+ * Unlike body_get_shape(), this does not copy the vertices: the returned
+ * shape points into a cache owned by the body, which holds the vertices
+ * relative to the centroid and the unit edge normals.
+ * If body_set_circle() or body_set_capsule() was called, the shape is that
+ * primitive rather than the body's polygon.
+ * The cache is only recomputed after the body rotates, so the shape
+ * is valid until the body is next rotated, ticked, or freed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's current collision shape
+ */
+collision_shape_t body_get_collision_shape(body_t *body);
+
+/**
+ * Gets the bounding box of a body's collision shape.
+ * Only recomputes the bounds after the body rotates; otherwise this just
+ * offsets the cached bounds by the centroid.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the smallest axis-aligned box containing the collision shape
+ */
+aabb_t body_get_aabb(body_t *body);
+
+/**
+ * Gets the handle of a body in its scene's broad phase.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the proxy set by the broad phase, or BODY_NO_PROXY
+ */
+size_t body_get_proxy(body_t *body);
+
+/**
+ * Records the handle of a body in a broad phase.
+ * Only the broad phase should call this.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param proxy the body's proxy, or BODY_NO_PROXY when it leaves
+ */
+void body_set_proxy(body_t *body, size_t proxy);
+
+/**
+ * Gets the position of a body among the bodies of its type in its scene
+ * (see scene_get_body_of_type()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the index set by the scene
+ */
+size_t body_get_type_index(body_t *body);
+
+/**
+ * Records the position of a body among the bodies of its type in its scene.
+ * Only the scene should call this.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param index the body's index among the bodies of its type
+ */
+void body_set_type_index(body_t *body, size_t index);
+
+/**
+ * Sets which collision categories a body belongs to and which it collides
+ * with. Two bodies are only checked for collisions if each one's category
+ * is in the other's mask, so pairs that never interact are rejected with a
+ * single bitmask test.
+ * Bodies start out in category 1 with mask COLLISION_MASK_ALL.
+ * A category of 0 keeps the body out of every collision.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param category the bits of the categories the body belongs to
+ * @param mask the bits of the categories the body collides with
+ */
+void body_set_collision_filter(body_t *body, uint32_t category, uint32_t mask);
+
+/**
+ * Gets the collision categories a body belongs to.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the category set with body_set_collision_filter()
+ */
+uint32_t body_get_collision_category(body_t *body);
+
+/**
+ * Gets the collision categories a body collides with.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the mask set with body_set_collision_filter()
+ */
+uint32_t body_get_collision_mask(body_t *body);
+
+/**
+ * Checks whether the collision filters of two bodies let them collide.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether each body's category is in the other's mask
+ */
+bool body_filters_collide(body_t *body1, body_t *body2);
+
+/**
+ * Makes a body a sensor (or a solid body again).
+ * A sensor only reports whether it overlaps other bodies: scenes check it
+ * with the cheaper find_shape_overlap() and pass its handlers a zero axis.
+ * Bodies start out solid.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param sensor whether the body should be a sensor
+ */
+void body_set_sensor(body_t *body, bool sensor);
+
+/**
+ * Returns whether a body is a sensor.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the value passed to body_set_sensor(), or false
+ */
+bool body_is_sensor(body_t *body);
+
+/**
+ * Makes a body a bullet (or an ordinary body again).
+ * Scenes check bullets for collisions along their whole path over each tick,
+ * instead of only where they are, so they cannot pass through thin bodies
+ * when they move further than their own size in one tick.
+ * Only fast, small bodies such as projectiles should need this.
+ * Bodies start out as ordinary bodies.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param bullet whether the body should be a bullet
+ */
+void body_set_bullet(body_t *body, bool bullet);
+
+/**
+ * Returns whether a body is a bullet.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the value passed to body_set_bullet(), or false
+ */
+bool body_is_bullet(body_t *body);
+
+/**
+ * Scales the forces a scene's force fields apply to a body (see
+ * scene_add_force_field()), e.g. 0 to exempt it from every field or 0.5 for
+ * a floaty body.
+ * Bodies start out with a scale of 1.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param scale the factor to multiply the fields' forces by
+ */
+void body_set_field_scale(body_t *body, double scale);
+
+/**
+ * Gets the factor a body's force field forces are multiplied by.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the value passed to body_set_field_scale(), or 1
+ */
+double body_get_field_scale(body_t *body);
+
+/**
+ * Makes a body collide as a circle centered on its centroid,
+ * instead of as its polygon. The polygon is still used for drawing.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param radius the radius of the circle
+ */
+void body_set_circle(body_t *body, double radius);
+
+/**
+ * Makes a body collide as a capsule (all points within radius of a segment),
+ * instead of as its polygon. The polygon is still used for drawing.
+ * The segment rotates with the body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param start one end of the segment, relative to the body's centroid
+ * @param end the other end of the segment, relative to the body's centroid
+ * @param radius the radius of the capsule
+ */
+void body_set_capsule(body_t *body, vector_t start, vector_t end,
+                      double radius);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -278,6 +471,26 @@ void body_set_color(body_t *body, rgb_color_t color);
  * @param body the body to tick
  * @param dt the number of seconds elapsed since the last tick
  */
+/**
+ * Computes the velocity body_tick() would give a body, given the forces and
+ * impulses applied to it so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param dt the length of the tick in seconds
+ * @return the velocity at the end of the tick
+ */
+vector_t body_get_next_velocity(body_t *body, double dt);
+
+/**
+ * Computes how far body_tick() would move a body, given the forces and
+ * impulses applied to it so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param dt the length of the tick in seconds
+ * @return the translation body_tick() would apply
+ */
+vector_t body_get_displacement(body_t *body, double dt);
+
 void body_tick(body_t *body, double dt);
 
 /**
@@ -0,0 +1,101 @@
+#ifndef __BODY_TABLE_H__
+#define __BODY_TABLE_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * The key of an entry of a body_table_t: one body, or an ordered pair.
+ * Tables keyed by a single body leave body2 NULL.
+ */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+} body_key_t;
+
+/**
+ * A hash table keyed by bodies, storing fixed-size entries inline.
+ * Each entry must start with its key, laid out like body_key_t; the rest of
+ * the entry belongs to the caller.
+ * The table uses open addressing with linear probing, and removing an entry
+ * shifts the later entries of its probe sequence back instead of leaving a
+ * tombstone, so lookups stay short however many entries come and go.
+ * Pointers to entries are valid until the next call that adds or removes an
+ * entry.
+ */
+typedef struct body_table body_table_t;
+
+/**
+ * Allocates an empty body table.
+ *
+ * @param entry_size the size of each entry, including its key
+ * @param capacity the number of slots to start with; a power of 2
+ * @return the new table
+ */
+body_table_t *body_table_init(size_t entry_size, size_t capacity);
+
+/**
+ * Releases the memory used by a body table.
+ * The bodies are not freed.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ */
+void body_table_free(body_table_t *table);
+
+/**
+ * Gets the number of entries in a body table.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @return the number of entries
+ */
+size_t body_table_size(body_table_t *table);
+
+/**
+ * Finds the entry with a given key.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @param body1 the first body of the key
+ * @param body2 the second body of the key, or NULL for a single body
+ * @return the entry, or NULL if there is none
+ */
+void *body_table_find(body_table_t *table, body_t *body1, body_t *body2);
+
+/**
+ * Finds the entry with a given key, adding one if there is none.
+ * The table grows when it becomes half full.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @param body1 the first body of the key; must not be NULL
+ * @param body2 the second body of the key, or NULL for a single body
+ * @return the entry; new entries are zeroed apart from the key
+ */
+void *body_table_add(body_table_t *table, body_t *body1, body_t *body2);
+
+/**
+ * Removes an entry from a body table.
+ * Another entry may be moved into the removed entry's slot.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @param entry an entry of the table
+ */
+void body_table_remove(body_table_t *table, void *entry);
+
+/**
+ * Gets the number of slots in a body table, for visiting every entry with
+ * body_table_get_slot().
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @return the number of slots
+ */
+size_t body_table_capacity(body_table_t *table);
+
+/**
+ * Gets the entry in a slot of a body table.
+ *
+ * @param table a pointer to a table returned from body_table_init()
+ * @param index the index of the slot, less than body_table_capacity()
+ * @return the entry, or NULL if the slot is empty
+ */
+void *body_table_get_slot(body_table_t *table, size_t index);
+
+#endif // #ifndef __BODY_TABLE_H__
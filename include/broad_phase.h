@@ -0,0 +1,166 @@
+#ifndef __BROAD_PHASE_H__
+#define __BROAD_PHASE_H__
+
+#include "body.h"
+#include "collision.h"
+#include <stdbool.h>
+
+/**
+ * The structures available for finding which bodies might be colliding
+ * before running the narrow phase on them.
+ * BROAD_PHASE_NONE tests every pair of bodies.
+ * BROAD_PHASE_AABB_TREE keeps the bodies' fattened bounding boxes in a
+ * dynamic tree, which copes well with bodies of very different sizes.
+ * BROAD_PHASE_SWEEP_AND_PRUNE keeps them sorted along x, which is cheapest
+ * when bodies mostly move together, as in a scrolling level.
+ */
+typedef enum {
+  BROAD_PHASE_NONE,
+  BROAD_PHASE_AABB_TREE,
+  BROAD_PHASE_SWEEP_AND_PRUNE
+} broad_phase_kind_t;
+
+/**
+ * A spatial index over the bounding boxes of a set of bodies.
+ * Each body's box is fattened so that small motions do not have to update
+ * the index; as a result the broad phase may report pairs whose real boxes
+ * are slightly apart, but never misses a pair whose boxes overlap.
+ */
+typedef struct broad_phase broad_phase_t;
+
+/**
+ * A function called on every pair of bodies found by the broad phase.
+ * Takes in an auxiliary value that can store parameters or state.
+ */
+typedef void (*body_pair_handler_t)(body_t *body1, body_t *body2, void *aux);
+
+/**
+ * A function called on every body found by a broad phase query.
+ * Returns whether to keep searching.
+ */
+typedef bool (*body_query_handler_t)(body_t *body, void *aux);
+
+/**
+ * Allocates an empty broad phase.
+ * Asserts that the kind is not BROAD_PHASE_NONE, which needs no index.
+ *
+ * @param kind the structure to use
+ * @return the new broad phase
+ */
+broad_phase_t *broad_phase_init(broad_phase_kind_t kind);
+
+/**
+ * Releases the memory used by a broad phase.
+ * The bodies are not freed, but they are no longer tracked.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ */
+void broad_phase_free(broad_phase_t *broad_phase);
+
+/**
+ * Gets the structure a broad phase uses.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @return the kind passed to broad_phase_init()
+ */
+broad_phase_kind_t broad_phase_get_kind(broad_phase_t *broad_phase);
+
+/**
+ * Starts tracking a body.
+ * Asserts that the body is not already in a broad phase.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param body the body to add
+ */
+void broad_phase_add(broad_phase_t *broad_phase, body_t *body);
+
+/**
+ * Stops tracking a body.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param body a body passed to broad_phase_add()
+ */
+void broad_phase_remove(broad_phase_t *broad_phase, body_t *body);
+
+/**
+ * Refreshes the boxes of all the tracked bodies after they have moved,
+ * as broad_phase_update_body() does.
+ * Only bodies that left their fat boxes are actually updated.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param dt the length of a tick, used to predict how far bodies will move
+ */
+void broad_phase_update(broad_phase_t *broad_phase, double dt);
+
+/**
+ * Refreshes the box of one tracked body.
+ * The box of a bullet (see body_set_bullet()) also covers the path it will
+ * take over the next tick, so it is found in every pair it could run into.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param body a body passed to broad_phase_add()
+ * @param dt the length of a tick, used to predict how far the body will move
+ */
+void broad_phase_update_body(broad_phase_t *broad_phase, body_t *body,
+                             double dt);
+
+/**
+ * Checks whether the fat boxes of two tracked bodies overlap.
+ * Bodies that are not tracked are assumed to overlap anything.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return false if the bodies cannot be colliding
+ */
+bool broad_phase_test_overlap(broad_phase_t *broad_phase, body_t *body1,
+                              body_t *body2);
+
+/**
+ * Calls a function once on every pair of tracked bodies whose fat boxes
+ * overlap.
+ * The handler must not add bodies to or remove bodies from the broad phase.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param handler the function to call on each pair
+ * @param aux an auxiliary value to pass to handler
+ */
+void broad_phase_find_pairs(broad_phase_t *broad_phase,
+                            body_pair_handler_t handler, void *aux);
+
+/**
+ * Calls a function on every tracked body whose fat box overlaps a box.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param aabb the box to search
+ * @param handler the function to call on each body found
+ * @param aux an auxiliary value to pass to handler
+ */
+void broad_phase_query(broad_phase_t *broad_phase, aabb_t aabb,
+                       body_query_handler_t handler, void *aux);
+
+/**
+ * Calls a function on every tracked body whose fat box a line segment
+ * passes through.
+ *
+ * @param broad_phase a pointer to a broad phase returned from
+ *   broad_phase_init()
+ * @param origin where the segment starts
+ * @param translation the vector from the start of the segment to its end
+ * @param handler the function to call on each body found
+ * @param aux an auxiliary value to pass to handler
+ */
+void broad_phase_raycast(broad_phase_t *broad_phase, vector_t origin,
+                         vector_t translation, body_query_handler_t handler,
+                         void *aux);
+
+#endif // #ifndef __BROAD_PHASE_H__
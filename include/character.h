@@ -0,0 +1,100 @@
+#ifndef __CHARACTER_H__
+#define __CHARACTER_H__
+
+#include "body.h"
+#include "collision.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A kinematic controller that moves a body through solid obstacles without
+ * ever overlapping them.
+ * Each tick, the body is swept along the path it would take and stopped at
+ * the first obstacle it hits; the rest of its motion slides along the
+ * obstacle's surface. Motion into the surfaces it touched is then removed
+ * from its velocity, so the body stands on floors and stops at walls
+ * without collision handlers.
+ *
+ * Scenes drive characters added with scene_add_character(): they add the
+ * obstacles near each character, sweep it before the bodies are ticked and
+ * finish the move afterwards.
+ */
+typedef struct character character_t;
+
+/**
+ * Allocates a controller for a body.
+ * The body is not owned by the controller.
+ *
+ * @param body the body to move
+ * @param solid_categories the collision categories of the bodies that block
+ *   the character (see body_set_collision_filter()); sensors never block it
+ * @return the new controller
+ */
+character_t *character_init(body_t *body, uint32_t solid_categories);
+
+/**
+ * Releases the memory used by a controller.
+ * The body is not freed.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ */
+void character_free(character_t *character);
+
+/**
+ * Gets the body moved by a controller.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ * @return the body passed to character_init()
+ */
+body_t *character_get_body(character_t *character);
+
+/**
+ * Returns whether the character was standing on a floor during the last
+ * tick, i.e. a surface facing up that it was pressing against.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ * @return whether the character is grounded
+ */
+bool character_is_grounded(character_t *character);
+
+/**
+ * Returns whether the character was pressing against a wall during the last
+ * tick, i.e. a surface facing left or right.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ * @return whether the character is against a wall
+ */
+bool character_is_against_wall(character_t *character);
+
+/**
+ * Adds a body that might block the character on the next sweep.
+ * Bodies outside the character's solid categories, sensors and the
+ * character's own body are ignored.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ * @param obstacle the body
+ */
+void character_add_obstacle(character_t *character, body_t *obstacle);
+
+/**
+ * Works out where the character will end a tick, by sweeping its body along
+ * the displacement body_tick() would give it against the obstacles added
+ * since the last sweep, each moving along its own displacement.
+ * The obstacles are then forgotten.
+ * Must be called after all the forces and impulses of the tick are applied.
+ *
+ * @param character a pointer to a controller returned from character_init()
+ * @param dt the length of the tick in seconds
+ */
+void character_sweep(character_t *character, double dt);
+
+/**
+ * Moves the character's body to the end of its swept path and removes the
+ * motion into the surfaces it hit from its velocity.
+ * Must be called after body_tick().
+ *
+ * @param character a pointer to a controller returned from character_init()
+ */
+void character_finish(character_t *character);
+
+#endif // #ifndef __CHARACTER_H__
@@ -4,6 +4,8 @@
 #include "list.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * Represents the status of a collision between two shapes.
@@ -16,18 +18,154 @@ typedef struct {
    * If the shapes are colliding, the axis they are colliding on.
    * This is a unit vector pointing from the first shape towards the second.
    * Normal impulses are applied along this axis.
-   * If collided is false, this value is undefined.
+   * If collided is false, this is the axis that separates the shapes.
    */
   vector_t axis;
-  double da_overlap; // added
+  /**
+   * If the shapes are colliding, how far they overlap along axis.
+   * If collided is false, the (non-positive) negated gap along axis.
+   */
+  double da_overlap;
 } collision_info_t;
 
+/**
+ * The result of sweeping two shapes along straight lines.
+ */
+typedef struct {
+  /** Whether the shapes touch at some point during the sweep */
+  bool hit;
+  /** The fraction of the sweep completed when they first touch, in [0, 1] */
+  double time;
+  /** The normal at the first contact, pointing from shape1 towards shape2 */
+  vector_t axis;
+  /**
+   * False if the search ran out of steps while the shapes were still
+   * approaching. Then hit is only set if they were nearly touching by the
+   * last step, and time is how far the sweep got; callers that must never
+   * let shapes pass through each other can treat this as a hit.
+   */
+  bool converged;
+} time_of_impact_t;
+
+/**
+ * The points where two overlapping shapes touch, found by clipping the edge
+ * of one shape that faces the other against the edge of the other shape.
+ */
+typedef struct {
+  /** The number of contact points, from 0 to 2 */
+  size_t count;
+  /** The contact normal, pointing from shape1 towards shape2 */
+  vector_t normal;
+  /** The contact points, in absolute coordinates */
+  vector_t points[2];
+  /** How far the shapes overlap along the normal at each point */
+  double depths[2];
+  /**
+   * Identifies the edge and vertex that produced each point, so a point can
+   * be matched with the same point on the next tick
+   */
+  uint32_t features[2];
+} contact_manifold_t;
+
+/**
+ * An axis-aligned bounding box.
+ */
+typedef struct {
+  /** The bottom left corner */
+  vector_t min;
+  /** The top right corner */
+  vector_t max;
+} aabb_t;
+
+/**
+ * The kinds of shapes the narrow phase understands.
+ * Circles and capsules are "rounded" shapes: every point within radius of
+ * their core (a single point for a circle, a segment for a capsule).
+ */
+typedef enum { SHAPE_POLYGON, SHAPE_CIRCLE, SHAPE_CAPSULE } shape_kind_t;
+
+/**
+ * A convex shape prepared for collision checks.
+ * The vertices and edge normals are stored relative to the centroid,
+ * so they stay valid while the shape translates and only have to be
+ * recomputed when it rotates (see body_get_collision_shape()).
+ * For a circle the vertices are just the center; for a capsule they are the
+ * two endpoints of its segment.
+ * The shape does not own any of the arrays it points to.
+ */
+typedef struct {
+  /** The number of vertices (and edges) of the shape */
+  size_t size;
+  /** The vertices of the shape relative to its centroid */
+  const vector_t *vertices;
+  /** The unit normal of the edge from vertices[i] to vertices[i + 1] */
+  const vector_t *normals;
+  /** The current position of the shape's centroid */
+  vector_t centroid;
+  /** What kind of shape this is */
+  shape_kind_t kind;
+  /** How far the shape extends past its vertices (0 for polygons) */
+  double radius;
+} collision_shape_t;
+
+/**
+ * Remembers which edge separated a pair of shapes the last time they were
+ * checked. Pairs usually stay separated by the same edge from one tick to
+ * the next, so trying it first lets most checks of a non-colliding pair
+ * finish after a single projection.
+ * Zero-initialize before the first check of a pair.
+ */
+typedef struct {
+  /** 0 if nothing is cached, 1 if the edge is on shape1, 2 if on shape2 */
+  int shape;
+  /** The index of the separating edge within that shape */
+  size_t edge;
+} separating_axis_cache_t;
+
+/**
+ * The algorithms available for the narrow phase.
+ * SAT projects every vertex onto every edge normal, which is fast for small
+ * polygons. GJK/EPA only asks each shape for its support points, which scales
+ * better for shapes with many vertices.
+ */
+typedef enum { NARROW_PHASE_SAT, NARROW_PHASE_GJK } narrow_phase_t;
+
+/**
+ * A batch of pairs of axis-aligned boxes, stored as parallel arrays so that
+ * several pairs can be tested at once.
+ * Box i of each side is centered at (x[i], y[i]) and extends half_width[i]
+ * horizontally and half_height[i] vertically from its center.
+ * The collided, axis_x, axis_y and overlap arrays are outputs.
+ */
+typedef struct {
+  /** The number of pairs in the batch */
+  size_t count;
+  const double *x1;
+  const double *y1;
+  const double *half_width1;
+  const double *half_height1;
+  const double *x2;
+  const double *y2;
+  const double *half_width2;
+  const double *half_height2;
+  /** Whether box 1 and box 2 of each pair are colliding */
+  bool *collided;
+  /** The collision axis of each pair, pointing from box 1 towards box 2 */
+  double *axis_x;
+  double *axis_y;
+  /** The overlap along the axis, or the negated gap if not colliding */
+  double *overlap;
+} box_batch_t;
+
 /**
  * Computes the status of the collision between two convex polygons.
  * The shapes are given as lists of vertices in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
  *
+ * Prefer find_shape_collision() with cached shapes when checking the same
+ * polygons repeatedly, since this has to prepare both shapes on every call.
+ *
  * @param shape1 the first shape
  * @param shape2 the second shape
  * @return whether the shapes are colliding, and if so, the collision axis.
@@ -35,4 +173,252 @@ typedef struct {
  */
 collision_info_t find_collision(list_t *shape1, list_t *shape2);
 
+/**
+ * Computes the status of the collision between two prepared convex shapes.
+ * Polygons only project the vertices onto the cached edge normals; no
+ * centroids or normals are recomputed. Two circles are tested directly by
+ * distance, and any other pair involving a circle or capsule adds the axes
+ * from its core towards the closest point of the other shape.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes are colliding, the collision axis (a unit vector
+ * pointing from shape1 towards shape2) and the overlap along that axis
+ */
+collision_info_t find_shape_collision(const collision_shape_t *shape1,
+                                      const collision_shape_t *shape2);
+
+/**
+ * Acts like find_shape_collision(), but first tests the separating axis
+ * remembered from the previous check of this pair and updates the cache
+ * with the result. The shapes must be passed in the same order every time.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param cache the pair's cache, or NULL to skip caching
+ * @return the same result as find_shape_collision()
+ */
+collision_info_t find_shape_collision_cached(const collision_shape_t *shape1,
+                                             const collision_shape_t *shape2,
+                                             separating_axis_cache_t *cache);
+
+/**
+ * Computes the status of the collision between two prepared convex shapes
+ * with GJK, falling back on EPA for the penetration depth when they overlap.
+ * Rounded shapes are handled by running GJK on their cores and accounting
+ * for the radii afterwards.
+ * Pairs that GJK does not settle within its iteration limit are checked
+ * with find_shape_collision() instead.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return the same result as find_shape_collision(), up to the precision
+ * of the iteration
+ */
+collision_info_t find_shape_collision_gjk(const collision_shape_t *shape1,
+                                          const collision_shape_t *shape2);
+
+/**
+ * Computes the status of the collision between two prepared convex shapes
+ * with the given algorithm.
+ *
+ * @param narrow_phase the algorithm to use
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param cache the pair's separating axis cache (only used by SAT), or NULL
+ * @return whether the shapes are colliding, the collision axis and overlap
+ */
+collision_info_t find_shape_collision_with(narrow_phase_t narrow_phase,
+                                           const collision_shape_t *shape1,
+                                           const collision_shape_t *shape2,
+                                           separating_axis_cache_t *cache);
+
+/**
+ * Checks whether two prepared convex shapes overlap, without working out the
+ * collision axis or depth.
+ * The bounding boxes are compared first, which settles the question for
+ * pairs of axis-aligned rectangles (e.g. sprites); any other pair that
+ * passes goes through find_shape_collision().
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether find_shape_collision() would report a collision
+ */
+bool find_shape_overlap(const collision_shape_t *shape1,
+                        const collision_shape_t *shape2);
+
+/**
+ * Finds the contact points of two colliding shapes.
+ * Two polygons touching along parallel edges get two points; every other
+ * pair gets the single deepest point.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param info the result of checking the shapes for a collision, e.g. with
+ *   find_shape_collision()
+ * @return the contact points, or none if info.collided is false
+ */
+contact_manifold_t find_contact_manifold(const collision_shape_t *shape1,
+                                         const collision_shape_t *shape2,
+                                         collision_info_t info);
+
+/**
+ * Finds when two shapes first touch while they translate at constant
+ * velocities, so that fast shapes cannot pass through thin ones between
+ * checks.
+ * The swept bounding boxes are compared first. Pairs that pass are advanced
+ * conservatively: each step moves them as far as the distance between them
+ * guarantees they cannot touch, until they are within TOI_TOLERANCE.
+ * If they are still approaching after TOI_MAX_ITERATIONS steps (e.g. a
+ * slow, grazing approach), the result is marked as not converged, and is
+ * only a hit if the shapes are within TOI_UNCONVERGED_TOLERANCE by then.
+ *
+ * @param shape1 the first shape, at the start of the sweep
+ * @param displacement1 how far shape1 moves during the sweep
+ * @param shape2 the second shape, at the start of the sweep
+ * @param displacement2 how far shape2 moves during the sweep
+ * @return the time and normal of the first contact, if there is one
+ */
+time_of_impact_t find_time_of_impact(const collision_shape_t *shape1,
+                                     vector_t displacement1,
+                                     const collision_shape_t *shape2,
+                                     vector_t displacement2);
+
+/**
+ * Finds where a ray first enters a shape, by sweeping a point along it with
+ * find_time_of_impact().
+ * A ray starting inside the shape hits it immediately.
+ *
+ * @param shape the shape
+ * @param origin where the ray starts
+ * @param translation the direction and length of the ray
+ * @return the fraction of translation at which the ray first touches the
+ *   shape, if it does; the axis is the shape's outward normal there
+ */
+time_of_impact_t find_ray_intersection(const collision_shape_t *shape,
+                                       vector_t origin, vector_t translation);
+
+/**
+ * Checks a batch of axis-aligned box pairs, several pairs at a time.
+ * Gives the same results as find_shape_collision() on the equivalent
+ * rectangles.
+ *
+ * @param batch the pairs to check; its output arrays are filled in
+ */
+void find_box_collisions(box_batch_t *batch);
+
+/**
+ * Checks many pairs of shapes in one call.
+ * Pairs where both shapes are axis-aligned rectangles (e.g. sprites) are
+ * packed into a box_batch_t and checked together by find_box_collisions();
+ * any other pair goes through find_shape_collision_with().
+ *
+ * @param narrow_phase the algorithm to use for the pairs that are not boxes
+ * @param count the number of pairs
+ * @param shapes1 the first shape of each pair
+ * @param shapes2 the second shape of each pair
+ * @param caches the separating axis cache of each pair (each may be NULL),
+ *   or NULL to skip caching
+ * @param results an array of count elements to write the results to
+ */
+void find_shape_collisions(narrow_phase_t narrow_phase, size_t count,
+                           const collision_shape_t *shapes1,
+                           const collision_shape_t *shapes2,
+                           separating_axis_cache_t **caches,
+                           collision_info_t *results);
+
+/**
+ * Checks whether a shape is an axis-aligned rectangle centered on its
+ * centroid.
+ *
+ * @param shape the shape to check
+ * @param half_extents if the shape is such a box, set to its half width and
+ * half height
+ * @return whether the shape is an axis-aligned box
+ */
+bool collision_shape_is_box(const collision_shape_t *shape,
+                            vector_t *half_extents);
+
+/**
+ * Finds the point of a shape that is farthest in a given direction.
+ * This is the only query GJK makes of a shape.
+ * The radius of rounded shapes is included.
+ *
+ * @param shape the shape
+ * @param direction the direction to search in (need not be a unit vector)
+ * @return the support point, in absolute coordinates
+ */
+vector_t collision_shape_support(const collision_shape_t *shape,
+                                 vector_t direction);
+
+/**
+ * Computes the bounding box of a shape, including the radius of rounded
+ * shapes.
+ *
+ * @param shape the shape
+ * @return the smallest axis-aligned box containing the shape
+ */
+aabb_t collision_shape_aabb(const collision_shape_t *shape);
+
+/**
+ * Checks whether two bounding boxes overlap.
+ * Boxes that only touch along an edge do not overlap.
+ *
+ * @param aabb1 the first box
+ * @param aabb2 the second box
+ * @return whether the boxes overlap
+ */
+bool aabb_overlap(aabb_t aabb1, aabb_t aabb2);
+
+/**
+ * Checks whether a line segment passes through a box.
+ *
+ * @param aabb the box
+ * @param origin where the segment starts
+ * @param translation the vector from the start of the segment to its end
+ * @return whether any point of the segment is inside the box
+ */
+bool aabb_ray_overlap(aabb_t aabb, vector_t origin, vector_t translation);
+
+/**
+ * Computes the smallest box containing two boxes.
+ *
+ * @param aabb1 the first box
+ * @param aabb2 the second box
+ * @return the union of the boxes
+ */
+aabb_t aabb_union(aabb_t aabb1, aabb_t aabb2);
+
+/**
+ * Checks whether a box lies entirely within another box.
+ *
+ * @param outer the containing box
+ * @param inner the contained box
+ * @return whether inner is inside outer
+ */
+bool aabb_contains(aabb_t outer, aabb_t inner);
+
+/**
+ * Grows a box by a margin on every side, then stretches it to also cover the
+ * box moved by a displacement.
+ *
+ * @param aabb the box to grow
+ * @param margin how far to grow each side
+ * @param displacement how far the box is expected to move
+ * @return the grown box
+ */
+aabb_t aabb_expand(aabb_t aabb, double margin, vector_t displacement);
+
+/**
+ * Computes the unit edge normals of a polygon.
+ * normals[i] is perpendicular to the edge from vertices[i] to vertices[i + 1]
+ * (wrapping around to vertices[0] for the last edge).
+ *
+ * @param size the number of vertices in the polygon
+ * @param vertices the vertices of the polygon
+ * @param normals an array of size elements to write the normals to
+ */
+void collision_compute_normals(size_t size, const vector_t *vertices,
+                               vector_t *normals);
+
 #endif // #ifndef __COLLISION_H__
@@ -0,0 +1,140 @@
+#ifndef __COMPONENT_STORE_H__
+#define __COMPONENT_STORE_H__
+
+#include "body.h"
+#include "timer_wheel.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * The kinds of behavior data a body can have in a component store.
+ */
+typedef enum {
+  COMPONENT_TIMER,
+  COMPONENT_EMITTER,
+  COMPONENT_TYPE_COUNT // the number of component types, not a type itself
+} component_type_t;
+
+/**
+ * The timer a body is waiting on, set by scene_schedule().
+ */
+typedef struct {
+  /** The body's timer in the scene's timing wheel; may have gone off */
+  timer_handle_t timer;
+} timer_component_t;
+
+/**
+ * Fires projectiles from a body, e.g. each time its timer goes off.
+ */
+typedef struct {
+  /** The type of projectile to fire (see scene_get_projectiles()) */
+  body_type_t projectile;
+  /** The velocity projectiles are fired with */
+  vector_t velocity;
+} emitter_component_t;
+
+/**
+ * Components of each type, stored in a dense array per type so that
+ * systems updating every component of a type sweep through contiguous
+ * memory instead of following each body's info pointer.
+ * Each body has at most one component of each type; a hash table per type
+ * finds the component of a given body.
+ * Removing a component moves the last component of its type into its slot,
+ * so indices are only stable while no components are removed.
+ */
+typedef struct component_store component_store_t;
+
+/**
+ * Allocates an empty component store.
+ *
+ * @return the new store
+ */
+component_store_t *component_store_init(void);
+
+/**
+ * Releases the memory used by a component store.
+ * The bodies are not freed.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ */
+void component_store_free(component_store_t *store);
+
+/**
+ * Gives a body a component of a type, zero-initialized.
+ * If the body already has one, it is returned unchanged.
+ * The pointer is only valid until a component of the same type is added or
+ * removed.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @param body the body
+ * @return a pointer to the body's component, e.g. a timer_component_t *
+ */
+void *component_store_add(component_store_t *store, component_type_t type,
+                          body_t *body);
+
+/**
+ * Gets a body's component of a type.
+ * The pointer is only valid until a component of the same type is added or
+ * removed.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @param body the body
+ * @return a pointer to the body's component, or NULL if it has none
+ */
+void *component_store_get(component_store_t *store, component_type_t type,
+                          body_t *body);
+
+/**
+ * Takes a body's component of a type away, if it has one.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @param body the body
+ */
+void component_store_remove(component_store_t *store, component_type_t type,
+                            body_t *body);
+
+/**
+ * Takes all of a body's components away, e.g. before it is freed.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param body the body
+ */
+void component_store_remove_body(component_store_t *store, body_t *body);
+
+/**
+ * Gets the number of components of a type.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @return the number of bodies with a component of that type
+ */
+size_t component_store_count(component_store_t *store, component_type_t type);
+
+/**
+ * Gets the component of a type at a given index in its dense array.
+ * Asserts that the index is valid.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @param index the index, less than component_store_count()
+ * @return a pointer to the component
+ */
+void *component_store_get_at(component_store_t *store, component_type_t type,
+                             size_t index);
+
+/**
+ * Gets the body that owns the component of a type at a given index.
+ * Asserts that the index is valid.
+ *
+ * @param store a pointer to a store returned from component_store_init()
+ * @param type the type of component
+ * @param index the index, less than component_store_count()
+ * @return the body
+ */
+body_t *component_store_get_body(component_store_t *store,
+                                 component_type_t type, size_t index);
+
+#endif // #ifndef __COMPONENT_STORE_H__
@@ -0,0 +1,57 @@
+#ifndef __CONTACT_SOLVER_H__
+#define __CONTACT_SOLVER_H__
+
+#include "collision.h"
+#include "pair_cache.h"
+#include <stddef.h>
+
+/**
+ * The number of passes contact_solver_solve() makes over the contacts
+ * unless a scene asks for another number.
+ */
+extern const size_t CONTACT_SOLVER_ITERATIONS;
+
+/**
+ * A touching pair of bodies for the contact solver to push apart.
+ */
+typedef struct {
+  /** The pair, whose manifold and impulses the solver reads and updates */
+  pair_entry_t *pair;
+  /** The coefficient of restitution, from 0 (no bounce) to 1 */
+  double elasticity;
+  /** The coefficient of friction along the contact */
+  double friction;
+  /** The approach speed to leave the contact with; set by the solver */
+  double bounce;
+} contact_constraint_t;
+
+/**
+ * Replaces the manifold of a pair with a new one.
+ * Points of the new manifold that come from the same features as points of
+ * the old one keep their impulses, so the solver can start from them.
+ *
+ * @param pair the pair to update
+ * @param manifold the pair's contact points on this tick
+ */
+void contact_solver_update_manifold(pair_entry_t *pair,
+                                    contact_manifold_t manifold);
+
+/**
+ * Applies impulses to every pair of touching bodies so that none of them
+ * keep approaching, then moves overlapping bodies part of the way apart.
+ * This is a sequential impulse solver: each pass fixes the velocity at one
+ * contact point at a time, and the impulse accumulated at each point is
+ * clamped so contacts only ever push. Passes start from the impulses of the
+ * last tick, so resting contacts converge in a few passes.
+ * The impulses are added with body_add_impulse(), so they take effect in
+ * body_tick().
+ *
+ * @param contacts the pairs to solve
+ * @param count the number of pairs
+ * @param dt the length of the tick in seconds
+ * @param iterations the number of passes over the contacts
+ */
+void contact_solver_solve(contact_constraint_t *contacts, size_t count,
+                          double dt, size_t iterations);
+
+#endif // #ifndef __CONTACT_SOLVER_H__
@@ -0,0 +1,85 @@
+#ifndef __FORCE_FIELD_H__
+#define __FORCE_FIELD_H__
+
+#include "body.h"
+#include "collision.h"
+#include "vector.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The kinds of force fields a scene can have.
+ */
+typedef enum {
+  /** Accelerates bodies uniformly, i.e. a force proportional to mass */
+  FORCE_FIELD_GRAVITY,
+  /** Slows bodies down with a force proportional to their velocity */
+  FORCE_FIELD_DRAG,
+  /** Drags bodies in a zone towards the velocity of the wind */
+  FORCE_FIELD_WIND
+} force_field_kind_t;
+
+/**
+ * A force that acts on every dynamic body (one with finite mass) in a
+ * scene, in place of a force creator per body.
+ * Only bodies whose collision category is one of the field's categories are
+ * affected, and the force on each body is multiplied by its field scale
+ * (see body_set_field_scale()).
+ * Use the functions below to make fields.
+ */
+typedef struct {
+  force_field_kind_t kind;
+  /** The acceleration of gravity, or the velocity of the wind */
+  vector_t vector;
+  /** The force per unit of velocity relative to the air, for drag and wind */
+  double gamma;
+  /** Where the wind blows; bodies are in it when their centroids are */
+  aabb_t zone;
+  /** The collision categories of the bodies the field acts on */
+  uint32_t categories;
+} force_field_t;
+
+/**
+ * Makes a field of uniform gravity.
+ *
+ * @param acceleration the acceleration due to gravity, e.g. {0, -g}
+ * @param categories the collision categories to act on
+ * @return the field
+ */
+force_field_t force_field_gravity(vector_t acceleration, uint32_t categories);
+
+/**
+ * Makes a field of linear drag, pushing each body with a force of -gamma
+ * times its velocity.
+ *
+ * @param gamma the proportionality constant between force and velocity
+ * @param categories the collision categories to act on
+ * @return the field
+ */
+force_field_t force_field_drag(double gamma, uint32_t categories);
+
+/**
+ * Makes a wind zone, pushing each body in the zone with a force of gamma
+ * times the wind's velocity relative to the body.
+ *
+ * @param zone the box the wind blows in
+ * @param velocity the velocity of the wind
+ * @param gamma the proportionality constant between force and velocity
+ * @param categories the collision categories to act on
+ * @return the field
+ */
+force_field_t force_field_wind(aabb_t zone, vector_t velocity, double gamma,
+                               uint32_t categories);
+
+/**
+ * Computes the total force a set of fields applies to a body.
+ *
+ * @param fields the fields
+ * @param count the number of fields
+ * @param body the body
+ * @return the force, which is zero for bodies with infinite mass
+ */
+vector_t force_fields_get_force(const force_field_t *fields, size_t count,
+                                body_t *body);
+
+#endif // #ifndef __FORCE_FIELD_H__
@@ -0,0 +1,45 @@
+#ifndef __FORCE_RECORD_H__
+#define __FORCE_RECORD_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * The kinds of built-in forces a scene stores as force records.
+ */
+typedef enum {
+  /** A Hooke's-law spring of constant k between two bodies */
+  FORCE_SPRING,
+  /** Newtonian gravity of constant G between two bodies */
+  FORCE_NEWTONIAN_GRAVITY,
+  /** Linear drag of constant gamma on one body */
+  FORCE_DRAG,
+  /** Constant downward acceleration g on one body */
+  FORCE_GRAVITY,
+  FORCE_KIND_COUNT // the number of force kinds, not a kind itself
+} force_kind_t;
+
+/**
+ * A built-in force, stored by value so that the forces of a kind sit in one
+ * contiguous array and are applied by one loop without calling through a
+ * function pointer per force.
+ */
+typedef struct {
+  body_t *body1;
+  /** The second body of a force between two bodies, otherwise NULL */
+  body_t *body2;
+  /** The force's constant: k, G, gamma or g depending on its kind */
+  double constant;
+} force_record_t;
+
+/**
+ * Applies an array of forces of one kind to their bodies.
+ *
+ * @param kind the kind of every force in the array
+ * @param records the forces
+ * @param count the number of forces
+ */
+void force_records_apply(force_kind_t kind, const force_record_t *records,
+                         size_t count);
+
+#endif // #ifndef __FORCE_RECORD_H__
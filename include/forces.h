@@ -5,20 +5,9 @@
 #include "state.h"
 
 /**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux);
-
-/**
- * Adds a force creator to a scene that applies gravity between two bodies.
- * The force creator will be called each tick
- * to compute the Newtonian gravitational force between the bodies.
+ * Adds a force to a scene that applies gravity between two bodies
+ * (see scene_add_force()).
+ * Each tick the scene computes the Newtonian gravitational force between the bodies.
  * See
  * https://en.wikipedia.org/wiki/Newton%27s_law_of_universal_gravitation#Vector_form.
  * The force should not be applied when the bodies are very close,
@@ -33,8 +22,23 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies constant acceleration due to
- * gravity to a body. The force creator will be called each tick
+ * Adds a group of bodies that all attract each other with Newtonian gravity
+ * to a scene (see gravity_group_t).
+ * Use this instead of create_newtonian_gravity() on every pair of bodies
+ * when there are more than a few dozen of them.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param theta the opening angle (see gravity_group_init())
+ * @return the group, owned by the scene, for gravity_group_add()
+ */
+gravity_group_t *create_gravity_group(scene_t *scene, double G,
+                                      double theta);
+
+/**
+ * Adds a force to a scene that applies constant acceleration due to
+ * gravity to a body (see scene_add_force()).
+ * See force_field_gravity() for gravity on many bodies at once.
  *
  * @param scene the scene containing the bodies
  * @param g vector acceleration due to gravity
@@ -43,9 +47,9 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
 void create_gravity(scene_t *scene, double gravity, body_t *body);
 
 /**
- * Adds a force creator to a scene that acts like a spring between two bodies.
- * The force creator will be called each tick
- * to compute the Hooke's-Law spring force between the bodies.
+ * Adds a force to a scene that acts like a spring between two bodies
+ * (see scene_add_force()).
+ * Each tick the scene computes the Hooke's-Law spring force between the bodies.
  * See https://en.wikipedia.org/wiki/Hooke%27s_law.
  *
  * @param scene the scene containing the bodies
@@ -56,10 +60,22 @@ void create_gravity(scene_t *scene, double gravity, body_t *body);
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies a drag force on a body.
- * The force creator will be called each tick
- * to compute the drag force on the body proportional to its velocity.
+ * Adds a network of damped springs to a scene (see spring_network_t).
+ * Use this instead of create_spring() for bodies joined by many springs,
+ * e.g. a soft body or a rope.
+ *
+ * @param scene the scene containing the bodies
+ * @return the network, owned by the scene, for spring_network_add_body()
+ *   and spring_network_add_spring()
+ */
+spring_network_t *create_spring_network(scene_t *scene);
+
+/**
+ * Adds a force to a scene that applies a drag force on a body
+ * (see scene_add_force()).
+ * Each tick the scene computes the drag force on the body proportional to its velocity.
  * The force points opposite the body's velocity.
+ * See force_field_drag() for drag on many bodies at once.
  *
  * @param scene the scene containing the bodies
  * @param gamma the proportionality constant between force and velocity
@@ -69,12 +85,13 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 void create_drag(scene_t *scene, double gamma, body_t *body);
 
 /**
- * Adds a force creator to a scene that calls a given collision handler
- * function each time two bodies collide.
+ * Makes a scene call a given collision handler function each time two
+ * bodies collide (see scene_add_pair_collision()).
  * This generalizes create_destructive_collision() from last week,
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
- * It should only be called once while the bodies are still colliding.
+ * It is called once when the bodies start colliding, and not again until
+ * they have separated.
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -0,0 +1,79 @@
+#ifndef __GRAVITY_GROUP_H__
+#define __GRAVITY_GROUP_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * A group of bodies that all attract each other with Newtonian gravity, in
+ * place of a force between every pair (see create_newtonian_gravity()).
+ * Each time the forces are applied, the bodies are sorted into a quadtree
+ * whose nodes know the total mass and center of mass of the bodies under
+ * them (a Barnes-Hut tree). A body then feels a whole node as a single mass
+ * whenever the node is small compared to its distance from the body, which
+ * takes O(n log n) time for n bodies instead of O(n^2).
+ *
+ * Like create_newtonian_gravity(), pairs of bodies (or nodes) closer than a
+ * small distance do not attract each other.
+ */
+typedef struct gravity_group gravity_group_t;
+
+/**
+ * Allocates a gravity group with no bodies.
+ *
+ * @param G the gravitational proportionality constant
+ * @param theta the opening angle: a node is treated as a single mass when
+ *   its width divided by its distance from a body is less than theta.
+ *   0 computes every pair exactly; around 0.5 is usually accurate enough.
+ * @return the new group
+ */
+gravity_group_t *gravity_group_init(double G, double theta);
+
+/**
+ * Releases the memory used by a gravity group.
+ * The bodies are not freed.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ */
+void gravity_group_free(gravity_group_t *group);
+
+/**
+ * Adds a body to a gravity group.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ * @param body the body to add
+ */
+void gravity_group_add(gravity_group_t *group, body_t *body);
+
+/**
+ * Gets the number of bodies in a gravity group.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ * @return the number of bodies
+ */
+size_t gravity_group_size(gravity_group_t *group);
+
+/**
+ * Changes the opening angle of a gravity group.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ * @param theta the new opening angle (see gravity_group_init())
+ */
+void gravity_group_set_theta(gravity_group_t *group, double theta);
+
+/**
+ * Takes the bodies that are marked for removal out of a gravity group,
+ * e.g. before they are freed.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ */
+void gravity_group_remove_dead(gravity_group_t *group);
+
+/**
+ * Adds the gravitational force on each body of a group from all the others.
+ *
+ * @param group a pointer to a group returned from gravity_group_init()
+ */
+void gravity_group_apply(gravity_group_t *group);
+
+#endif // #ifndef __GRAVITY_GROUP_H__
@@ -54,6 +54,19 @@ size_t list_size(list_t *list);
  */
 void *list_get(list_t *list, size_t index);
 
+/**
+ * Replaces the element at a given index in a list and returns the old one.
+ * The old element is not freed.
+ * Asserts that the index is valid, given the list's current size, and that
+ * the new value is non-NULL.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index an index in the list (the first element is at 0)
+ * @param value the new element
+ * @return the element that was at the given index
+ */
+void *list_set(list_t *list, size_t index, void *value);
+
 /**
  * Removes the element at a given index in a list and returns it,
  * moving all subsequent elements towards the start of the list.
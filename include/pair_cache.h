@@ -0,0 +1,100 @@
+#ifndef __PAIR_CACHE_H__
+#define __PAIR_CACHE_H__
+
+#include "body.h"
+#include "collision.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The state a scene keeps for a pair of bodies between ticks.
+ * The bodies are stored in the order they are passed to the narrow phase,
+ * which must be the same on every tick for the separating axis cache to work.
+ * They come first, laid out like a body_key_t, since they are the entry's key
+ * in the cache's body_table_t.
+ */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+  /** The edge that separated the bodies last time they were checked */
+  separating_axis_cache_t axis_cache;
+  /** Whether the bodies were touching after the last check */
+  bool touching;
+  /** The last tick on which the broad phase reported this pair */
+  size_t last_seen;
+  /** The contact points from the last check, if the pair is solid */
+  contact_manifold_t manifold;
+  /** The impulses the contact solver applied at each point last tick */
+  double normal_impulses[2];
+  double tangent_impulses[2];
+} pair_entry_t;
+
+/**
+ * A hash table of pair_entry_t keyed by the two bodies.
+ * Entries are stored inline, so looking up or adding a pair does not
+ * allocate unless the table has to grow.
+ */
+typedef struct pair_cache pair_cache_t;
+
+/**
+ * A function called on every entry dropped by pair_cache_sweep().
+ * The entry is only valid during the call.
+ */
+typedef void (*pair_expire_t)(pair_entry_t *entry, void *aux);
+
+/**
+ * Allocates an empty pair cache.
+ *
+ * @return the new cache
+ */
+pair_cache_t *pair_cache_init(void);
+
+/**
+ * Releases the memory used by a pair cache.
+ * The bodies are not freed.
+ *
+ * @param cache a pointer to a cache returned from pair_cache_init()
+ */
+void pair_cache_free(pair_cache_t *cache);
+
+/**
+ * Gets the number of pairs in a cache.
+ *
+ * @param cache a pointer to a cache returned from pair_cache_init()
+ * @return the number of entries
+ */
+size_t pair_cache_size(pair_cache_t *cache);
+
+/**
+ * Finds the entry for a pair of bodies, adding a fresh one if there is none,
+ * and marks it as seen on the given tick.
+ * (body1, body2) and (body2, body1) are different pairs.
+ * The returned pointer is valid until the next call that changes the cache.
+ *
+ * @param cache a pointer to a cache returned from pair_cache_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param tick the current tick
+ * @return the pair's entry; new entries are zeroed apart from the bodies
+ *   and last_seen
+ */
+pair_entry_t *pair_cache_touch(pair_cache_t *cache, body_t *body1,
+                               body_t *body2, size_t tick);
+
+/**
+ * Drops every entry that was not seen on the given tick or that has a body
+ * marked for removal (see body_remove()).
+ * Sweep before removed bodies are freed, since the cache never looks at a
+ * body again once its entries are gone.
+ *
+ * @param cache a pointer to a cache returned from pair_cache_init()
+ * @param tick the current tick
+ * @param expire if non-NULL, a function to call on each dropped entry
+ *   before it is removed; it must not change the cache
+ * @param aux an auxiliary value to pass to expire
+ * @return the number of entries dropped
+ */
+size_t pair_cache_sweep(pair_cache_t *cache, size_t tick, pair_expire_t expire,
+                        void *aux);
+
+#endif // #ifndef __PAIR_CACHE_H__
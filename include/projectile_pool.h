@@ -0,0 +1,177 @@
+#ifndef __PROJECTILE_POOL_H__
+#define __PROJECTILE_POOL_H__
+
+#include "body.h"
+#include "collision.h"
+#include "vector.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A function called when a projectile hits one of its pool's targets.
+ * Takes in the body that was hit, where the projectile was, and an auxiliary
+ * value that can store parameters or state.
+ */
+typedef void (*projectile_handler_t)(body_t *target, vector_t position,
+                                     void *aux);
+
+/**
+ * A fixed number of identical circular projectiles, e.g. enemy bullets,
+ * that are not bodies.
+ * Positions and velocities are stored as parallel arrays, allocated once,
+ * and moved together each tick. Every projectile lives for the same time,
+ * so they expire in the order they were spawned: the pool is a ring buffer
+ * from the oldest projectile to the newest, and a full pool recycles its
+ * oldest projectile. Spawning never allocates.
+ *
+ * Projectiles are indexed from the oldest (0) to the newest. Projectiles
+ * destroyed by a hit keep their index, marked as no longer alive, until
+ * every older projectile has expired.
+ */
+typedef struct projectile_pool projectile_pool_t;
+
+/**
+ * Allocates an empty pool.
+ * Asserts that the capacity is positive.
+ *
+ * @param capacity the most projectiles alive at once
+ * @param radius the radius of each projectile
+ * @param lifetime the number of seconds each projectile lasts
+ * @param texture_path the path of the PNG texture to draw projectiles with,
+ *   or NULL to not draw them
+ * @return the new pool
+ */
+projectile_pool_t *projectile_pool_init(size_t capacity, double radius,
+                                        double lifetime,
+                                        const char *texture_path);
+
+/**
+ * Releases the memory used by a pool.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ */
+void projectile_pool_free(projectile_pool_t *pool);
+
+/**
+ * Sets which bodies the pool's projectiles hit.
+ * A projectile touching a body in one of the target categories calls the
+ * handler and is destroyed; one touching a body in one of the solid
+ * categories is just destroyed. Sensors and removed bodies are ignored.
+ * Projectiles pass through everything until this is called.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param target_categories the collision categories to call handler on
+ *   (see body_set_collision_filter())
+ * @param handler the function to call on each hit of a target
+ * @param aux an auxiliary value to pass to handler; not freed
+ * @param solid_categories the collision categories that stop projectiles
+ */
+void projectile_pool_set_targets(projectile_pool_t *pool,
+                                 uint32_t target_categories,
+                                 projectile_handler_t handler, void *aux,
+                                 uint32_t solid_categories);
+
+/**
+ * Fires a new projectile, recycling the oldest one if the pool is full.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param position where the projectile starts
+ * @param velocity the projectile's velocity
+ */
+void projectile_pool_spawn(projectile_pool_t *pool, vector_t position,
+                           vector_t velocity);
+
+/**
+ * Gets the number of projectile indices in use, including destroyed
+ * projectiles waiting for older ones to expire.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the number of indices
+ */
+size_t projectile_pool_size(projectile_pool_t *pool);
+
+/**
+ * Gets the number of projectiles that have not expired or been destroyed.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the number of live projectiles
+ */
+size_t projectile_pool_live(projectile_pool_t *pool);
+
+/**
+ * Gets whether a projectile is still flying.
+ * Asserts that the index is valid.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param index the index of the projectile, less than projectile_pool_size()
+ * @return false if the projectile was destroyed
+ */
+bool projectile_pool_is_alive(projectile_pool_t *pool, size_t index);
+
+/**
+ * Gets the position of a projectile.
+ * Asserts that the index is valid.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param index the index of the projectile, less than projectile_pool_size()
+ * @return the center of the projectile
+ */
+vector_t projectile_pool_get_position(projectile_pool_t *pool, size_t index);
+
+/**
+ * Gets the radius of the pool's projectiles.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the radius
+ */
+double projectile_pool_get_radius(projectile_pool_t *pool);
+
+/**
+ * Gets the texture the pool's projectiles are drawn with.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the texture, or NULL if the projectiles are not drawn
+ */
+SDL_Texture *projectile_pool_get_texture(projectile_pool_t *pool);
+
+/**
+ * Gets a box around every live projectile.
+ * The box can still cover projectiles destroyed since the last
+ * projectile_pool_advance().
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the box, which is empty (min greater than max) if there are no
+ *   live projectiles
+ */
+aabb_t projectile_pool_get_bounds(projectile_pool_t *pool);
+
+/**
+ * Gets the collision categories a pool's projectiles hit.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @return the union of the target and solid categories
+ */
+uint32_t projectile_pool_get_mask(projectile_pool_t *pool);
+
+/**
+ * Moves every projectile by its velocity and recycles those that have
+ * expired.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param dt the number of seconds that have passed
+ */
+void projectile_pool_advance(projectile_pool_t *pool, double dt);
+
+/**
+ * Checks every live projectile against a body, destroying those that hit it
+ * (see projectile_pool_set_targets()).
+ * Projectiles whose boxes miss the body's box are rejected before any shape
+ * is built.
+ *
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ * @param body the body to check
+ */
+void projectile_pool_collide(projectile_pool_t *pool, body_t *body);
+
+#endif // #ifndef __PROJECTILE_POOL_H__
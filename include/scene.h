@@ -2,7 +2,16 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "broad_phase.h"
+#include "character.h"
+#include "component_store.h"
+#include "force_field.h"
+#include "force_record.h"
+#include "gravity_group.h"
 #include "list.h"
+#include "projectile_pool.h"
+#include "spring_network.h"
+#include "timer_wheel.h"
 
 /**
  * A collection of bodies and force creators.
@@ -18,6 +27,73 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function called when a collision occurs.
+ * @param body1 the first body passed to create_collision(),
+ *   or the body of type1 passed to scene_add_collision_handler()
+ * @param body2 the second body passed to create_collision(),
+ *   or the body of type2 passed to scene_add_collision_handler()
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed when registering the handler
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux);
+
+/**
+ * The changes in contact between two bodies that a contact handler hears
+ * about.
+ * CONTACT_BEGIN is sent on the first tick the bodies touch, CONTACT_PERSIST
+ * on each following tick they still touch, and CONTACT_END once they
+ * separate or one of them is removed.
+ */
+typedef enum {
+  CONTACT_BEGIN,
+  CONTACT_PERSIST,
+  CONTACT_END
+} contact_event_t;
+
+/**
+ * A function called when the contact between two bodies changes.
+ * @param body1 the body of type1 passed to scene_add_contact_handler()
+ * @param body2 the body of type2 passed to scene_add_contact_handler()
+ * @param event what happened to the contact
+ * @param axis for CONTACT_BEGIN and CONTACT_PERSIST, a unit vector pointing
+ *   from body1 towards body2 along which they are colliding;
+ *   not meaningful for CONTACT_END
+ * @param aux the auxiliary value passed to scene_add_contact_handler()
+ */
+typedef void (*contact_handler_t)(body_t *body1, body_t *body2,
+                                  contact_event_t event, vector_t axis,
+                                  void *aux);
+
+/**
+ * A body found by scene_raycast() or scene_shape_cast().
+ */
+typedef struct {
+  /** The body that was hit */
+  body_t *body;
+  /** The fraction of the cast's translation completed at the hit, in [0, 1] */
+  double fraction;
+  /**
+   * For a ray, where it hits the body; for a shape cast, where the cast
+   * body's centroid is when it first touches the body
+   */
+  vector_t point;
+  /** The outward normal of the body's surface at the hit */
+  vector_t normal;
+} scene_hit_t;
+
+/**
+ * A body found by scene_query_radius() or scene_query_nearest().
+ */
+typedef struct {
+  /** The body that was found */
+  body_t *body;
+  /** The squared distance from the query's center to the body's centroid */
+  double distance_squared;
+} scene_neighbor_t;
+
 /**
  * A text object containing all info to be rendered on the scene.
  * Implemented in sdl_wrapper.
@@ -62,8 +138,150 @@ size_t scene_bodies(scene_t *scene);
  */
 body_t *scene_get_body(scene_t *scene, size_t index);
 
+/**
+ * Gets the number of bodies of a type in a scene.
+ * The scene keeps a list of the bodies of each type, updated as bodies are
+ * added and removed, so looking for the bodies of one type only visits
+ * those bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type the type of body
+ * @return the number of bodies of that type
+ */
+size_t scene_bodies_of_type(scene_t *scene, body_type_t type);
+
+/**
+ * Gets the body of a type at a given index.
+ * The bodies of a type are not kept in any particular order: removing one
+ * moves the last body of its type into its place.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type the type of body
+ * @param index the index of the body among the bodies of its type
+ * @return a pointer to the body
+ */
+body_t *scene_get_body_of_type(scene_t *scene, body_type_t type,
+                               size_t index);
+
+/**
+ * Gets the components of the bodies in a scene (see component_store_t).
+ * A body's components are removed when the scene frees the body.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's component store
+ */
+component_store_t *scene_get_components(scene_t *scene);
+
+/**
+ * Calls a function after a delay, at the start of the first scene_tick()
+ * reaching it, before forces are applied.
+ * Only timers that go off cost anything, so idle bodies waiting on long
+ * timers are free. A callback can schedule again to repeat.
+ *
+ * A body waits on at most one timer, kept in its timer_component_t:
+ * scheduling for the body again replaces its timer, and the timer is
+ * cancelled when the scene frees the body.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body the body to pass to callback, or NULL for a timer of the
+ *   scene itself
+ * @param delay the number of seconds to wait
+ * @param callback the function to call
+ * @param aux an auxiliary value to pass to callback; not freed
+ * @return a handle for scene_cancel_timer()
+ */
+timer_handle_t scene_schedule(scene_t *scene, body_t *body, double delay,
+                              timer_callback_t callback, void *aux);
+
+/**
+ * Stops a timer scheduled with scene_schedule() from going off.
+ * Does nothing if it already went off or was cancelled.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle the handle returned from scene_schedule()
+ */
+void scene_cancel_timer(scene_t *scene, timer_handle_t handle);
+
+/**
+ * Gives a scene a pool of projectiles of a type, e.g. for enemies to fire
+ * bullets into without allocating a body per bullet.
+ * Each scene_tick() moves the projectiles and checks them against the
+ * bodies they can hit (see projectile_pool_set_targets()).
+ * The scene takes ownership of the pool, freeing any pool it already had
+ * for the type.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type the type of projectile the pool holds
+ * @param pool a pointer to a pool returned from projectile_pool_init()
+ */
+void scene_set_projectiles(scene_t *scene, body_type_t type,
+                           projectile_pool_t *pool);
+
+/**
+ * Gets a scene's pool of projectiles of a type.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type the type of projectile
+ * @return the pool, or NULL if the scene has none for the type
+ */
+projectile_pool_t *scene_get_projectiles(scene_t *scene, body_type_t type);
+
+/**
+ * Adds a force field to a scene, acting on all of its dynamic bodies at the
+ * start of each scene_tick(), before the force creators run.
+ * Fields cost one pass over the bodies per tick however many bodies they
+ * act on, and need no per-body setup (see body_set_field_scale()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param field the field, e.g. from force_field_gravity()
+ * @return the index of the field, for scene_get_force_field()
+ */
+size_t scene_add_force_field(scene_t *scene, force_field_t field);
+
+/**
+ * Gets the number of force fields in a scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of fields
+ */
+size_t scene_force_fields(scene_t *scene);
+
+/**
+ * Gets a force field of a scene, which can be changed in place, e.g. to
+ * make a wind gust or turn a field off by clearing its categories.
+ * Asserts that the index is valid.
+ * The pointer is only valid until another field is added.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index returned from scene_add_force_field()
+ * @return a pointer to the field
+ */
+force_field_t *scene_get_force_field(scene_t *scene, size_t index);
+
+/**
+ * Adds a gravity group to a scene, which then owns it.
+ * The group's forces are applied each tick along with the built-in forces,
+ * and bodies are taken out of the group when they are removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param group a group returned from gravity_group_init()
+ */
+void scene_add_gravity_group(scene_t *scene, gravity_group_t *group);
+
+/**
+ * Adds a spring network to a scene, which then owns it.
+ * The network's springs are applied each tick along with the built-in
+ * forces, and bodies are taken out of the network when they are removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param network a network returned from spring_network_init()
+ */
+void scene_add_spring_network(scene_t *scene, spring_network_t *network);
+
 /**
  * Adds a body to a scene.
+ * During scene_tick(), the body is added at the end of the tick instead.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
@@ -75,12 +293,48 @@ void scene_add_body(scene_t *scene, body_t *body);
  *
  * Removes and frees the body at a given index from a scene.
  * Asserts that the index is valid.
+ * During scene_tick(), the body is marked for removal at the end of the tick
+ * instead.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param index the index of the body in the scene (starting at 0)
  */
 void scene_remove_body(scene_t *scene, size_t index);
 
+/**
+ * Moves a body of a scene, like body_set_centroid().
+ * During scene_tick(), e.g. from a collision handler, the body is moved at
+ * the end of the tick instead, so the rest of the tick sees it where it was.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a body in the scene
+ * @param centroid the body's new centroid
+ */
+void scene_set_centroid(scene_t *scene, body_t *body, vector_t centroid);
+
+/**
+ * Changes the velocity of a body of a scene, like body_set_velocity().
+ * During scene_tick(), the velocity is changed at the end of the tick
+ * instead.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a body in the scene
+ * @param velocity the body's new velocity
+ */
+void scene_set_velocity(scene_t *scene, body_t *body, vector_t velocity);
+
+/**
+ * Adds a character controller to a scene, which then moves the character's
+ * body on every tick (see character_t).
+ * The scene takes ownership of the controller and frees it when the scene is
+ * freed or the body is removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param character a pointer to a controller returned from character_init(),
+ *   whose body is in the scene
+ */
+void scene_add_character(scene_t *scene, character_t *character);
+
 /**
  * @deprecated Use scene_add_bodies_force_creator() instead
  * so the scene knows which bodies the force creator depends on
@@ -107,18 +361,285 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer);
 
+/**
+ * Adds a built-in force to a scene, applied every time scene_tick() is
+ * called and removed when any of its bodies is removed.
+ * The scene keeps the forces of each kind in one array and applies them in
+ * one loop per kind, before the force creators run.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force
+ * @param constant the force's constant (see force_record_t)
+ * @param body1 the body the force acts on
+ * @param body2 the other body of a force between two bodies, otherwise NULL
+ */
+void scene_add_force(scene_t *scene, force_kind_t kind, double constant,
+                     body_t *body1, body_t *body2);
+
+/**
+ * Calls a function each time two particular bodies start colliding; it is
+ * not called again until they separate.
+ * Like the forces added with scene_add_force(), the pairs are kept in one
+ * array and checked in one loop, and a pair is removed when either body is.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body1 the body passed to the handler first
+ * @param body2 the body passed to the handler second
+ * @param handler the function to call when the bodies collide
+ * @param aux an auxiliary value to pass to handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_pair_collision(scene_t *scene, body_t *body1, body_t *body2,
+                              collision_handler_t handler, void *aux,
+                              free_func_t freer);
+
+/**
+ * Registers a function to call whenever a body of one type collides with a
+ * body of another type.
+ * Unlike create_collision(), this is done once for the whole scene rather
+ * than once per pair of bodies: every tick, the broad phase finds the pairs
+ * that might be touching, pairs whose collision filters reject each other
+ * (see body_set_collision_filter()) are skipped, and the narrow phase is only
+ * run on pairs of types with a handler.
+ * The handler is called on every tick that the bodies are colliding.
+ * Pairs involving a sensor (see body_set_sensor()) are only tested for
+ * overlap, after all the other pairs, and their handlers get a zero axis.
+ * Registering any handler for (type1, type2) or (type2, type1) replaces this
+ * one.
+ * During scene_tick(), the handler is registered at the end of the tick
+ * instead.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type1 the type of the body passed to the handler first
+ * @param type2 the type of the body passed to the handler second
+ * @param handler the function to call on each colliding pair
+ * @param aux an auxiliary value to pass to handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_collision_handler(scene_t *scene, body_type_t type1,
+                                 body_type_t type2,
+                                 collision_handler_t handler, void *aux,
+                                 free_func_t freer);
+
+/**
+ * Registers a function to call whenever the contact between a body of one
+ * type and a body of another type begins, persists or ends.
+ * Works like scene_add_collision_handler(), but the scene remembers which
+ * pairs were touching on the previous tick, so the handler can react once
+ * per contact instead of on every tick.
+ * Registering any handler for (type1, type2) or (type2, type1) replaces this
+ * one.
+ * During scene_tick(), the handler is registered at the end of the tick
+ * instead.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type1 the type of the body passed to the handler first
+ * @param type2 the type of the body passed to the handler second
+ * @param handler the function to call on each contact event
+ * @param aux an auxiliary value to pass to handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_contact_handler(scene_t *scene, body_type_t type1,
+                               body_type_t type2, contact_handler_t handler,
+                               void *aux, free_func_t freer);
+
+/**
+ * Makes the contact solver push apart touching bodies of two types, in
+ * either order, so that they rest on or bounce off each other.
+ * The solver runs during scene_tick(), after all the collision handlers, and
+ * applies its impulses with body_add_impulse(). Handlers registered for the
+ * same types are still called. Bodies with mass INFINITY are never moved.
+ * Pairs that are only found to touch by sweeping a bullet are left to the
+ * handlers.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param type1 the type of one of the bodies
+ * @param type2 the type of the other body
+ * @param elasticity the coefficient of restitution of the contact;
+ *   0 is a perfectly inelastic collision and 1 is a perfectly elastic one
+ * @param friction the coefficient of friction of the contact
+ */
+void scene_add_solid_collision(scene_t *scene, body_type_t type1,
+                               body_type_t type2, double elasticity,
+                               double friction);
+
+/**
+ * Sets how many passes the contact solver makes over the touching pairs on
+ * each tick. More passes let stacks of bodies settle faster.
+ * Scenes start with CONTACT_SOLVER_ITERATIONS.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param iterations the number of passes
+ */
+void scene_set_solver_iterations(scene_t *scene, size_t iterations);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
+ * This requires executing all the force creators,
+ * dispatching the collision handlers added with scene_add_collision_handler(),
+ * solving the contacts added with scene_add_solid_collision(),
+ * sweeping the characters added with scene_add_character()
  * and then ticking each body (see body_tick()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * A pair involving a bullet (see body_set_bullet()) is also reported to its
+ * handlers if the bodies would touch at any point during the tick, with the
+ * normal at the moment they first touch.
+ *
+ * Bodies, force creators, forces, pair collisions and collision or contact
+ * handlers added while the tick runs (e.g. by a force creator or handler),
+ * and the changes made with scene_remove_body(), scene_set_centroid() and
+ * scene_set_velocity(), are queued and made in the order they were
+ * requested at one sync point, after the projectiles move and before the
+ * bodies are removed and ticked.
+ * So the scene's bodies, forces and handlers stay the same from the start
+ * of the tick to the sync point, and forces added during a tick first act
+ * on the next.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Chooses the algorithm used to check collisions between bodies in the scene.
+ * Scenes start out using NARROW_PHASE_SAT.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param narrow_phase the collision algorithm to use
+ */
+void scene_set_narrow_phase(scene_t *scene, narrow_phase_t narrow_phase);
+
+/**
+ * Gets the algorithm used to check collisions between bodies in the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the collision algorithm set with scene_set_narrow_phase()
+ */
+narrow_phase_t scene_get_narrow_phase(scene_t *scene);
+
+/**
+ * Chooses how the scene finds the pairs of bodies that might be colliding.
+ * Scenes start out using BROAD_PHASE_NONE; switching rebuilds the index
+ * from the bodies currently in the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param broad_phase the structure to use
+ */
+void scene_set_broad_phase(scene_t *scene, broad_phase_kind_t broad_phase);
+
+/**
+ * Gets how the scene finds the pairs of bodies that might be colliding.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the structure set with scene_set_broad_phase()
+ */
+broad_phase_kind_t scene_get_broad_phase(scene_t *scene);
+
+/**
+ * Checks with the broad phase whether two bodies might be colliding.
+ * This is a cheap test that force creators can use to skip the narrow phase.
+ * Always returns true if the scene has no broad phase.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return false if the bodies are definitely not colliding
+ */
+bool scene_bodies_may_collide(scene_t *scene, body_t *body1, body_t *body2);
+
+/**
+ * Calls a function once on every pair of bodies in the scene whose
+ * bounding boxes might overlap.
+ * Without a broad phase, every pair of bodies has its boxes checked.
+ * The boxes of bullets cover their paths over the last tick.
+ * The pairs are all found before the handler is first called, so the handler
+ * may add or remove bodies; bodies added this way are not reported.
+ * The handler must not call scene_find_pairs() itself.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handler the function to call on each pair
+ * @param aux an auxiliary value to pass to handler
+ */
+void scene_find_pairs(scene_t *scene, body_pair_handler_t handler, void *aux);
+
+/**
+ * Finds every body a line segment hits, without running any collision
+ * handlers.
+ * The broad phase narrows the search down to the bodies whose boxes the
+ * segment crosses, so probing the ground below a body or the line of sight
+ * between two bodies is cheap.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin where the segment starts
+ * @param translation the vector from the start of the segment to its end
+ * @param mask only bodies whose collision category shares a bit with mask
+ *   are hit (see body_set_collision_filter())
+ * @return a list of scene_hit_t, nearest first, which the caller must free
+ *   with list_free()
+ */
+list_t *scene_raycast(scene_t *scene, vector_t origin, vector_t translation,
+                      uint32_t mask);
+
+/**
+ * Finds every body a body would hit if it moved along a translation, without
+ * moving it or running any collision handlers.
+ * The other bodies are treated as standing still.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body the body to cast, which is never hit itself
+ * @param translation how far the body would move
+ * @param mask only bodies whose collision category shares a bit with mask
+ *   are hit (see body_set_collision_filter())
+ * @return a list of scene_hit_t, nearest first, which the caller must free
+ *   with list_free()
+ */
+list_t *scene_shape_cast(scene_t *scene, body_t *body, vector_t translation,
+                         uint32_t mask);
+
+/**
+ * Finds every body whose bounding box overlaps a box.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param aabb the box to search
+ * @param mask only bodies whose collision category shares a bit with mask
+ *   are found (see body_set_collision_filter())
+ * @return a list of the bodies, ordered by the distance from their centroids
+ *   to the center of the box, which the caller must free with list_free()
+ *   (the bodies are not freed)
+ */
+list_t *scene_overlap_aabb(scene_t *scene, aabb_t aabb, uint32_t mask);
+
+/**
+ * Finds every body whose centroid is within a radius of a point, e.g. the
+ * pickups a power-up should attract.
+ * Only the bodies the broad phase finds around the point are measured.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param center the point to search around
+ * @param radius how far from center to search
+ * @param type the only type of body to find, or BODY_TYPE_COUNT for any type
+ * @return a list of scene_neighbor_t, nearest first, which the caller must
+ *   free with list_free()
+ */
+list_t *scene_query_radius(scene_t *scene, vector_t center, double radius,
+                           body_type_t type);
+
+/**
+ * Finds the k bodies whose centroids are nearest to a point.
+ * The search starts close to the point and widens until it holds k bodies,
+ * so it only looks at the bodies around the point when they are dense.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param center the point to search around
+ * @param k how many bodies to find
+ * @param type the only type of body to find, or BODY_TYPE_COUNT for any type
+ * @return a list of at most k scene_neighbor_t, nearest first, which the
+ *   caller must free with list_free()
+ */
+list_t *scene_query_nearest(scene_t *scene, vector_t center, size_t k,
+                            body_type_t type);
+
 /**
  * Gets the width of the scene in blocks
  *
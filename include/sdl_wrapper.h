@@ -117,6 +117,13 @@ void sdl_free_text(text_t *text);
  */
 void sdl_draw_sprite(body_t *sprite);
 
+/**
+ * Draws the live projectiles of a pool with the pool's texture.
+ *
+ * @param pool the pool to draw
+ */
+void sdl_draw_projectiles(projectile_pool_t *pool);
+
 /**
  * Displays the rendered frame on the SDL window.
  * Must be called after drawing the polygons in order to show them.
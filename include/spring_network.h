@@ -0,0 +1,95 @@
+#ifndef __SPRING_NETWORK_H__
+#define __SPRING_NETWORK_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * A set of damped springs between bodies, e.g. the joints of a soft body or
+ * a rope, applied together in place of one force per spring (see
+ * create_spring()).
+ * The springs are stored in compressed sparse rows: the springs of each body
+ * sit together, each stored once under the lower-numbered of its two bodies.
+ * Each tick the bodies' positions and velocities are copied into flat arrays,
+ * all the springs are evaluated in one pass over those arrays, and the summed
+ * force on each body is added to it at the end.
+ *
+ * Each spring pulls its bodies together with a force of
+ * k (distance - rest length) + damping (rate the distance is growing),
+ * along the line between their centroids.
+ */
+typedef struct spring_network spring_network_t;
+
+/**
+ * Allocates a spring network with no bodies or springs.
+ *
+ * @return the new network
+ */
+spring_network_t *spring_network_init(void);
+
+/**
+ * Releases the memory used by a spring network.
+ * The bodies are not freed.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ */
+void spring_network_free(spring_network_t *network);
+
+/**
+ * Adds a body to a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @param body the body to add
+ * @return the body's index in the network, for spring_network_add_spring().
+ *   Indices change when removed bodies are taken out of the network.
+ */
+size_t spring_network_add_body(spring_network_t *network, body_t *body);
+
+/**
+ * Adds a spring between two bodies of a spring network.
+ * Asserts that the indices are valid and different.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @param index1 the index of the first body
+ * @param index2 the index of the second body
+ * @param k the Hooke's constant for the spring
+ * @param rest_length the distance at which the spring exerts no force
+ * @param damping the force per unit of speed resisting the bodies moving
+ *   apart or together
+ */
+void spring_network_add_spring(spring_network_t *network, size_t index1,
+                               size_t index2, double k, double rest_length,
+                               double damping);
+
+/**
+ * Gets the number of bodies in a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @return the number of bodies
+ */
+size_t spring_network_bodies(spring_network_t *network);
+
+/**
+ * Gets the number of springs in a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @return the number of springs
+ */
+size_t spring_network_springs(spring_network_t *network);
+
+/**
+ * Takes the bodies that are marked for removal out of a spring network,
+ * along with their springs, e.g. before they are freed.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ */
+void spring_network_remove_dead(spring_network_t *network);
+
+/**
+ * Adds the forces of all the springs of a network to their bodies.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ */
+void spring_network_apply(spring_network_t *network);
+
+#endif // #ifndef __SPRING_NETWORK_H__
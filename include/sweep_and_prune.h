@@ -0,0 +1,136 @@
+#ifndef __SWEEP_AND_PRUNE_H__
+#define __SWEEP_AND_PRUNE_H__
+
+#include "aabb_tree.h"
+#include "collision.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A list of axis-aligned boxes kept sorted by their left edges.
+ * Overlapping pairs are found by sweeping the list from left to right and
+ * only comparing each box with the boxes that start before it ends.
+ * Like aabb_tree_t, each proxy stores a fattened copy of its box.
+ *
+ * The list is re-sorted with insertion sort, which takes close to linear time
+ * when the order barely changes between updates, e.g. in a scrolling level
+ * where everything moves left together.
+ * Removed proxies leave holes that are closed the next time the list is
+ * sorted, so removing many proxies at once costs a single pass.
+ */
+typedef struct sweep_and_prune sweep_and_prune_t;
+
+/**
+ * A function called on every pair of proxies found by a sweep.
+ *
+ * @param data1 the data of the proxy that starts further left
+ * @param data2 the data of the other proxy
+ * @param aux the auxiliary value passed to the sweep
+ */
+typedef void (*sweep_pair_t)(void *data1, void *data2, void *aux);
+
+/**
+ * Allocates an empty list.
+ *
+ * @param margin how far each proxy's fat box extends past its real box
+ * @return the new list
+ */
+sweep_and_prune_t *sweep_and_prune_init(double margin);
+
+/**
+ * Releases the memory used by a list.
+ * The data stored in the proxies is not freed.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ */
+void sweep_and_prune_free(sweep_and_prune_t *sap);
+
+/**
+ * Adds a proxy to a list.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param aabb the box of the object
+ * @param data a value to associate with the proxy
+ * @return the new proxy, which stays valid until it is removed
+ */
+size_t sweep_and_prune_insert(sweep_and_prune_t *sap, aabb_t aabb,
+                              void *data);
+
+/**
+ * Removes a proxy from a list.
+ * The proxy can be reused right away; its slot in the sorted order is
+ * dropped at the next sweep or query.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param proxy a proxy returned from sweep_and_prune_insert()
+ */
+void sweep_and_prune_remove(sweep_and_prune_t *sap, size_t proxy);
+
+/**
+ * Updates the box of a proxy.
+ * Does nothing if the new box still fits within the proxy's fat box.
+ * Otherwise, the fat box is recomputed and extended in the direction of
+ * displacement. The list is re-sorted before the next sweep or query.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param proxy a proxy returned from sweep_and_prune_insert()
+ * @param aabb the new box of the object
+ * @param displacement how far the object is expected to move before its
+ *   fat box should need recomputing
+ * @return whether the fat box changed
+ */
+bool sweep_and_prune_move(sweep_and_prune_t *sap, size_t proxy, aabb_t aabb,
+                          vector_t displacement);
+
+/**
+ * Gets the fat box of a proxy.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param proxy a proxy returned from sweep_and_prune_insert()
+ * @return the box stored in the list, which contains the object's box
+ */
+aabb_t sweep_and_prune_get_fat_aabb(sweep_and_prune_t *sap, size_t proxy);
+
+/**
+ * Calls a function once on every pair of proxies whose fat boxes overlap.
+ * The function must not modify the list.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param callback the function to call on each pair
+ * @param aux an auxiliary value to pass to callback
+ */
+void sweep_and_prune_find_pairs(sweep_and_prune_t *sap, sweep_pair_t callback,
+                                void *aux);
+
+/**
+ * Finds every proxy whose fat box overlaps a box.
+ * Binary searches for the first proxy that could reach the box, so the cost
+ * depends on the number of proxies near the box rather than to its left.
+ * Very wide proxies, e.g. a background, would push that search far to the
+ * left, so they are left out of it and checked one by one instead.
+ * The callback must not modify the list.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param aabb the box to search
+ * @param callback a function called on every proxy found,
+ *   which can stop the search by returning false
+ * @param aux an auxiliary value to pass to callback
+ */
+void sweep_and_prune_query(sweep_and_prune_t *sap, aabb_t aabb,
+                           aabb_query_t callback, void *aux);
+
+/**
+ * Calls a function on every proxy in a list, in no particular order.
+ * The callback may move proxies with sweep_and_prune_move(),
+ * but must not insert or remove any.
+ *
+ * @param sap a pointer to a list returned from sweep_and_prune_init()
+ * @param callback a function called on every proxy,
+ *   which can stop the iteration by returning false
+ * @param aux an auxiliary value to pass to callback
+ */
+void sweep_and_prune_for_each(sweep_and_prune_t *sap, aabb_query_t callback,
+                              void *aux);
+
+#endif // #ifndef __SWEEP_AND_PRUNE_H__
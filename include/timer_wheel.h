@@ -0,0 +1,94 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * A function called when a timer goes off.
+ * Takes in the body the timer was scheduled for (or NULL) and an auxiliary
+ * value that can store parameters or state.
+ */
+typedef void (*timer_callback_t)(body_t *body, void *aux);
+
+/**
+ * Identifies a scheduled timer, so it can be cancelled.
+ * Handles of timers that have gone off or been cancelled stay safe to
+ * cancel; nothing happens.
+ */
+typedef struct {
+  size_t index;
+  size_t generation;
+} timer_handle_t;
+
+/**
+ * A hierarchical timing wheel: a scheduler for many timers that only
+ * touches timers when they go off.
+ * Time advances in ticks of a fixed resolution. The first level has a slot
+ * for each of the next few ticks; each further level has a slot for each of
+ * the next few spans covered by a whole level below it. A timer sits in the
+ * slot of the lowest level its deadline fits in, and is moved down a level
+ * when the wheel reaches its slot, so advancing costs the same however many
+ * timers are waiting.
+ */
+typedef struct timer_wheel timer_wheel_t;
+
+/**
+ * Allocates a timing wheel with no timers.
+ *
+ * @param resolution the length of a tick in seconds; timers go off on the
+ *   first tick at or after their deadline
+ * @return the new wheel
+ */
+timer_wheel_t *timer_wheel_init(double resolution);
+
+/**
+ * Releases the memory used by a timing wheel.
+ * Waiting timers are dropped without going off.
+ *
+ * @param wheel a pointer to a wheel returned from timer_wheel_init()
+ */
+void timer_wheel_free(timer_wheel_t *wheel);
+
+/**
+ * Gets the number of timers waiting to go off.
+ *
+ * @param wheel a pointer to a wheel returned from timer_wheel_init()
+ * @return the number of timers
+ */
+size_t timer_wheel_size(timer_wheel_t *wheel);
+
+/**
+ * Schedules a function to be called after a delay.
+ * Timers always wait at least one tick.
+ *
+ * @param wheel a pointer to a wheel returned from timer_wheel_init()
+ * @param delay the number of seconds to wait
+ * @param callback the function to call
+ * @param body a body to pass to callback, or NULL
+ * @param aux an auxiliary value to pass to callback
+ * @return a handle for cancelling the timer
+ */
+timer_handle_t timer_wheel_schedule(timer_wheel_t *wheel, double delay,
+                                    timer_callback_t callback, body_t *body,
+                                    void *aux);
+
+/**
+ * Stops a timer from going off.
+ *
+ * @param wheel a pointer to a wheel returned from timer_wheel_init()
+ * @param handle a handle returned from timer_wheel_schedule()
+ */
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_handle_t handle);
+
+/**
+ * Moves time forward, calling the functions of the timers that go off in
+ * the order of their deadlines.
+ * Callbacks may schedule and cancel timers.
+ *
+ * @param wheel a pointer to a wheel returned from timer_wheel_init()
+ * @param dt the number of seconds that have passed
+ */
+void timer_wheel_advance(timer_wheel_t *wheel, double dt);
+
+#endif // #ifndef __TIMER_WHEEL_H__
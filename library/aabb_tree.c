@@ -0,0 +1,347 @@
+#include "aabb_tree.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t AABB_TREE_NULL = SIZE_MAX;
+const size_t AABB_TREE_INITIAL_CAPACITY = 16;
+// the deepest a query can descend; a balanced tree of 2^32 leaves fits.
+// An enum, since a const size_t would make the query stacks VLAs
+enum { AABB_STACK_SIZE = 256 };
+
+typedef struct {
+  aabb_t aabb;
+  void *data;
+  // the parent node, or the next free node if this one is unused
+  size_t parent;
+  size_t child1;
+  size_t child2;
+  // 0 for leaves, -1 for free nodes
+  int height;
+} tree_node_t;
+
+struct aabb_tree {
+  tree_node_t *nodes;
+  size_t capacity;
+  size_t root;
+  size_t free_list;
+  double margin;
+};
+
+bool tree_node_is_leaf(const tree_node_t *node) {
+  return node->child1 == AABB_TREE_NULL;
+}
+
+/**
+ * Half the perimeter of a box, the cost the tree tries to minimize.
+ */
+double tree_cost(aabb_t aabb) {
+  return (aabb.max.x - aabb.min.x) + (aabb.max.y - aabb.min.y);
+}
+
+/**
+ * Links nodes [start, capacity) into the free list.
+ */
+void tree_link_free_nodes(aabb_tree_t *tree, size_t start) {
+  for (size_t i = start; i < tree->capacity; i++) {
+    tree->nodes[i].parent = i + 1 < tree->capacity ? i + 1 : AABB_TREE_NULL;
+    tree->nodes[i].height = -1;
+  }
+  tree->free_list = start;
+}
+
+aabb_tree_t *aabb_tree_init(double margin) {
+  aabb_tree_t *tree = malloc(sizeof(aabb_tree_t));
+  assert(tree);
+  tree->capacity = AABB_TREE_INITIAL_CAPACITY;
+  tree->nodes = malloc(tree->capacity * sizeof(tree_node_t));
+  assert(tree->nodes);
+  tree->root = AABB_TREE_NULL;
+  tree->margin = margin;
+  tree_link_free_nodes(tree, 0);
+  return tree;
+}
+
+void aabb_tree_free(aabb_tree_t *tree) {
+  free(tree->nodes);
+  free(tree);
+}
+
+/**
+ * Takes a node off the free list, growing the pool if it is empty.
+ * This can move the pool, so node pointers must be refetched afterwards.
+ */
+size_t tree_allocate_node(aabb_tree_t *tree) {
+  if (tree->free_list == AABB_TREE_NULL) {
+    size_t old_capacity = tree->capacity;
+    tree->capacity *= 2;
+    tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(tree_node_t));
+    assert(tree->nodes);
+    tree_link_free_nodes(tree, old_capacity);
+  }
+  size_t index = tree->free_list;
+  tree_node_t *node = &tree->nodes[index];
+  tree->free_list = node->parent;
+  node->parent = AABB_TREE_NULL;
+  node->child1 = AABB_TREE_NULL;
+  node->child2 = AABB_TREE_NULL;
+  node->data = NULL;
+  node->height = 0;
+  return index;
+}
+
+void tree_free_node(aabb_tree_t *tree, size_t index) {
+  tree->nodes[index].parent = tree->free_list;
+  tree->nodes[index].height = -1;
+  tree->free_list = index;
+}
+
+/**
+ * Replaces the child pointer to old_child in parent (or the root).
+ */
+void tree_replace_child(aabb_tree_t *tree, size_t parent, size_t old_child,
+                        size_t new_child) {
+  if (parent == AABB_TREE_NULL) {
+    tree->root = new_child;
+  } else if (tree->nodes[parent].child1 == old_child) {
+    tree->nodes[parent].child1 = new_child;
+  } else {
+    tree->nodes[parent].child2 = new_child;
+  }
+}
+
+int tree_max_height(int a, int b) { return a > b ? a : b; }
+
+/**
+ * Recomputes the box and height of an internal node from its children.
+ */
+void tree_refit_node(aabb_tree_t *tree, size_t index) {
+  tree_node_t *node = &tree->nodes[index];
+  tree_node_t *child1 = &tree->nodes[node->child1];
+  tree_node_t *child2 = &tree->nodes[node->child2];
+  node->aabb = aabb_union(child1->aabb, child2->aabb);
+  node->height = 1 + tree_max_height(child1->height, child2->height);
+}
+
+/**
+ * If one subtree of node a is more than one level taller than the other,
+ * rotates the taller child up to take a's place.
+ *
+ * @return the node now at a's position
+ */
+size_t tree_balance(aabb_tree_t *tree, size_t a) {
+  tree_node_t *node_a = &tree->nodes[a];
+  if (tree_node_is_leaf(node_a) || node_a->height < 2) {
+    return a;
+  }
+  size_t b = node_a->child1;
+  size_t c = node_a->child2;
+  int difference = tree->nodes[c].height - tree->nodes[b].height;
+  if (difference >= -1 && difference <= 1) {
+    return a;
+  }
+
+  // promote the taller child p; its shorter grandchild moves down to a
+  size_t p = difference > 1 ? c : b;
+  tree_node_t *node_p = &tree->nodes[p];
+  size_t f = node_p->child1;
+  size_t g = node_p->child2;
+  size_t keep = tree->nodes[f].height > tree->nodes[g].height ? f : g;
+  size_t give = keep == f ? g : f;
+
+  node_p->parent = node_a->parent;
+  tree_replace_child(tree, node_p->parent, a, p);
+  node_p->child1 = a;
+  node_p->child2 = keep;
+  node_a->parent = p;
+  if (p == c) {
+    node_a->child2 = give;
+  } else {
+    node_a->child1 = give;
+  }
+  tree->nodes[give].parent = a;
+  tree_refit_node(tree, a);
+  tree_refit_node(tree, p);
+  return p;
+}
+
+/**
+ * Walks from index up to the root, rebalancing and refitting every node.
+ */
+void tree_fix_upwards(aabb_tree_t *tree, size_t index) {
+  while (index != AABB_TREE_NULL) {
+    index = tree_balance(tree, index);
+    tree_refit_node(tree, index);
+    index = tree->nodes[index].parent;
+  }
+}
+
+void tree_insert_leaf(aabb_tree_t *tree, size_t leaf) {
+  if (tree->root == AABB_TREE_NULL) {
+    tree->root = leaf;
+    tree->nodes[leaf].parent = AABB_TREE_NULL;
+    return;
+  }
+
+  // descend towards the sibling that increases the total perimeter least
+  aabb_t leaf_aabb = tree->nodes[leaf].aabb;
+  size_t index = tree->root;
+  while (!tree_node_is_leaf(&tree->nodes[index])) {
+    tree_node_t *node = &tree->nodes[index];
+    double cost = tree_cost(node->aabb);
+    double combined_cost = tree_cost(aabb_union(node->aabb, leaf_aabb));
+    // cost of making the leaf a sibling of this node
+    double sibling_cost = 2 * combined_cost;
+    // cost every descendant pays for growing this node
+    double inheritance_cost = 2 * (combined_cost - cost);
+
+    double child_costs[2];
+    size_t children[2] = {node->child1, node->child2};
+    for (size_t i = 0; i < 2; i++) {
+      tree_node_t *child = &tree->nodes[children[i]];
+      double grown = tree_cost(aabb_union(leaf_aabb, child->aabb));
+      if (!tree_node_is_leaf(child)) {
+        grown -= tree_cost(child->aabb);
+      }
+      child_costs[i] = grown + inheritance_cost;
+    }
+    if (sibling_cost < child_costs[0] && sibling_cost < child_costs[1]) {
+      break;
+    }
+    index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+  }
+
+  size_t sibling = index;
+  size_t new_parent = tree_allocate_node(tree);
+  tree_node_t *parent_node = &tree->nodes[new_parent];
+  size_t old_parent = tree->nodes[sibling].parent;
+  parent_node->parent = old_parent;
+  parent_node->child1 = sibling;
+  parent_node->child2 = leaf;
+  tree_replace_child(tree, old_parent, sibling, new_parent);
+  tree->nodes[sibling].parent = new_parent;
+  tree->nodes[leaf].parent = new_parent;
+  tree_fix_upwards(tree, new_parent);
+}
+
+void tree_remove_leaf(aabb_tree_t *tree, size_t leaf) {
+  if (leaf == tree->root) {
+    tree->root = AABB_TREE_NULL;
+    return;
+  }
+  size_t parent = tree->nodes[leaf].parent;
+  size_t grandparent = tree->nodes[parent].parent;
+  size_t sibling = tree->nodes[parent].child1 == leaf
+                       ? tree->nodes[parent].child2
+                       : tree->nodes[parent].child1;
+  tree_replace_child(tree, grandparent, parent, sibling);
+  tree->nodes[sibling].parent = grandparent;
+  tree_free_node(tree, parent);
+  tree_fix_upwards(tree, grandparent);
+}
+
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t aabb, void *data) {
+  size_t proxy = tree_allocate_node(tree);
+  tree->nodes[proxy].aabb = aabb_expand(aabb, tree->margin, VEC_ZERO);
+  tree->nodes[proxy].data = data;
+  tree_insert_leaf(tree, proxy);
+  return proxy;
+}
+
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy) {
+  assert(proxy < tree->capacity && tree_node_is_leaf(&tree->nodes[proxy]));
+  tree_remove_leaf(tree, proxy);
+  tree_free_node(tree, proxy);
+}
+
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t aabb,
+                    vector_t displacement) {
+  assert(proxy < tree->capacity && tree_node_is_leaf(&tree->nodes[proxy]));
+  if (aabb_contains(tree->nodes[proxy].aabb, aabb)) {
+    return false;
+  }
+
+  tree_remove_leaf(tree, proxy);
+  tree->nodes[proxy].aabb = aabb_expand(aabb, tree->margin, displacement);
+  tree_insert_leaf(tree, proxy);
+  return true;
+}
+
+aabb_t aabb_tree_get_fat_aabb(aabb_tree_t *tree, size_t proxy) {
+  assert(proxy < tree->capacity);
+  return tree->nodes[proxy].aabb;
+}
+
+void *aabb_tree_get_data(aabb_tree_t *tree, size_t proxy) {
+  assert(proxy < tree->capacity);
+  return tree->nodes[proxy].data;
+}
+
+void aabb_tree_query(aabb_tree_t *tree, aabb_t aabb, aabb_query_t callback,
+                     void *aux) {
+  size_t stack[AABB_STACK_SIZE];
+  size_t count = 0;
+  if (tree->root != AABB_TREE_NULL) {
+    stack[count++] = tree->root;
+  }
+  while (count > 0) {
+    size_t index = stack[--count];
+    tree_node_t *node = &tree->nodes[index];
+    if (!aabb_overlap(node->aabb, aabb)) {
+      continue;
+    }
+    if (tree_node_is_leaf(node)) {
+      if (!callback(index, node->data, aux)) {
+        return;
+      }
+    } else {
+      assert(count + 2 <= AABB_STACK_SIZE);
+      stack[count++] = node->child1;
+      stack[count++] = node->child2;
+    }
+  }
+}
+
+void aabb_tree_raycast(aabb_tree_t *tree, vector_t origin,
+                       vector_t translation, aabb_query_t callback, void *aux) {
+  size_t stack[AABB_STACK_SIZE];
+  size_t count = 0;
+  if (tree->root != AABB_TREE_NULL) {
+    stack[count++] = tree->root;
+  }
+  while (count > 0) {
+    size_t index = stack[--count];
+    tree_node_t *node = &tree->nodes[index];
+    if (!aabb_ray_overlap(node->aabb, origin, translation)) {
+      continue;
+    }
+    if (tree_node_is_leaf(node)) {
+      if (!callback(index, node->data, aux)) {
+        return;
+      }
+    } else {
+      assert(count + 2 <= AABB_STACK_SIZE);
+      stack[count++] = node->child1;
+      stack[count++] = node->child2;
+    }
+  }
+}
+
+void aabb_tree_for_each(aabb_tree_t *tree, aabb_query_t callback, void *aux) {
+  // the callback may move proxies, which can grow the pool, so the capacity
+  // and node pointers are reread on every iteration
+  for (size_t i = 0; i < tree->capacity; i++) {
+    tree_node_t *node = &tree->nodes[i];
+    if (node->height == 0 && !callback(i, node->data, aux)) {
+      return;
+    }
+  }
+}
+
+size_t aabb_tree_height(aabb_tree_t *tree) {
+  if (tree->root == AABB_TREE_NULL) {
+    return 0;
+  }
+  return tree->nodes[tree->root].height;
+}
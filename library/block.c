@@ -4,7 +4,6 @@
 #include <math.h>
 #include <stdlib.h>
 
-const size_t CIRCLE_N_POINTS = 180;
 const rgb_color_t OBSTACLE_COLOR = {0.05, 0.05, 0.05};
 const double PLAYER_MASS = 10;
 const double GEN_TIME = 1.0;
@@ -13,6 +12,10 @@ const double ENEMY_MASS = 10;
 const double BLOCK_WIDTH = 10;
 const double PROJ_VELOCITY = 50;
 const int SIZE_ADJ = 4;
+const uint32_t CATEGORY_PLAYER = 1 << 0;
+const uint32_t CATEGORY_TERRAIN = 1 << 1;
+const uint32_t CATEGORY_ENEMY = 1 << 2;
+const uint32_t CATEGORY_PICKUP = 1 << 3;
 
 struct obstacle_info {
   double time_since;
@@ -183,18 +186,22 @@ body_t *gen_portal() {
 }
 
 body_t *gen_ball(int level) {
+  body_t *b = NULL;
   if (level == 1) {
-    return sprite_init(ENEMY_MASS, SPACESHIP, "assets/level_1_sprites/ball.png",
-                       BLOCK_WIDTH * 2, BLOCK_WIDTH * 2);
+    b = sprite_init(ENEMY_MASS, SPACESHIP, "assets/level_1_sprites/ball.png",
+                    BLOCK_WIDTH * 2, BLOCK_WIDTH * 2);
   } else if (level == 2) {
-    return sprite_init(ENEMY_MASS, SPACESHIP,
-                       "assets/level_2_sprites/water-bullet.png",
-                       BLOCK_WIDTH * 2, BLOCK_WIDTH * 2);
+    b = sprite_init(ENEMY_MASS, SPACESHIP,
+                    "assets/level_2_sprites/water-bullet.png",
+                    BLOCK_WIDTH * 2, BLOCK_WIDTH * 2);
   }
-  return NULL;
+  if (b != NULL) {
+    body_set_circle(b, BLOCK_WIDTH);
+  }
+  return b;
 }
 
-body_t *block_init(body_type_t body_type) {
+body_t *gen_block(body_type_t body_type) {
 
   switch (body_type) {
   case PLAYER:
@@ -260,6 +267,45 @@ body_t *block_init(body_type_t body_type) {
   }
 }
 
+/**
+ * Gets the collision category of a type of block.
+ */
+uint32_t block_category(body_type_t body_type) {
+  switch (body_type) {
+  case PLAYER:
+    return CATEGORY_PLAYER;
+  case GROUND:
+  case WALL:
+  case SAND:
+  case SAND_WALL:
+    return CATEGORY_TERRAIN;
+  case COIN:
+  case MAGNET:
+  case PORTAL:
+    return CATEGORY_PICKUP;
+  default:
+    return CATEGORY_ENEMY;
+  }
+}
+
+body_t *block_init(body_type_t body_type) {
+  body_t *block = gen_block(body_type);
+  if (block == NULL) {
+    return NULL;
+  }
+  // everything but the player only ever interacts with the player
+  uint32_t category = block_category(body_type);
+  uint32_t mask =
+      category == CATEGORY_PLAYER ? COLLISION_MASK_ALL : CATEGORY_PLAYER;
+  body_set_collision_filter(block, category, mask);
+  // pickups only need to know when the player reaches them
+  body_set_sensor(block, category == CATEGORY_PICKUP);
+  // projectiles can cross a whole block in one slow frame
+  body_set_bullet(block, body_type == FIREBALL || body_type == WATERBALL ||
+                             body_type == BALL || body_type == BULLET);
+  return block;
+}
+
 void block_set_pos(body_t *block, size_t x_index, size_t y_index,
                    vector_t absolute_origin) {
 
@@ -1,16 +1,20 @@
 #include "body.h"
+#include "collision.h"
 #include "polygon.h"
 #include "sdl_wrapper.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_surface.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
 const double MAX_ELASTICITY = 1.0;
 const double MIN_ELASTICITY = 0.8;
+const size_t BODY_NO_PROXY = SIZE_MAX;
+const uint32_t COLLISION_MASK_ALL = UINT32_MAX;
 
 struct body {
   list_t *shape;
@@ -29,6 +33,28 @@ struct body {
   bool marked_for_removal;
   SDL_Texture *texture;
   bool flipped;
+
+  // shape relative to the centroid and its edge normals, for collisions
+  vector_t *local_vertices;
+  vector_t *normals;
+  bool collision_cache_valid;
+  // collision primitive; for capsules, the segment relative to the centroid
+  shape_kind_t collision_kind;
+  double collision_radius;
+  vector_t capsule[2];
+  // bounds of the collision shape relative to the centroid
+  aabb_t local_bounds;
+  // handle of the body in its scene's broad phase
+  size_t proxy;
+  // position of the body in its scene's list of bodies of its type
+  size_t type_index;
+  // see body_set_collision_filter()
+  uint32_t collision_category;
+  uint32_t collision_mask;
+  bool sensor;
+  bool bullet;
+  // see body_set_field_scale()
+  double field_scale;
 };
 
 body_t *body_init(list_t *shape, double mass, rgb_color_t color,
@@ -51,6 +77,20 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color,
   body->marked_for_removal = false;
   body->texture = NULL;
   body->flipped = false;
+  body->local_vertices = NULL;
+  body->normals = NULL;
+  body->collision_cache_valid = false;
+  body->collision_kind = SHAPE_POLYGON;
+  body->collision_radius = 0;
+  body->capsule[0] = VEC_ZERO;
+  body->capsule[1] = VEC_ZERO;
+  body->proxy = BODY_NO_PROXY;
+  body->type_index = 0;
+  body->collision_category = 1;
+  body->collision_mask = COLLISION_MASK_ALL;
+  body->sensor = false;
+  body->bullet = false;
+  body->field_scale = 1;
   return body;
 }
 
@@ -72,6 +112,20 @@ body_t *sprite_init(double mass, body_type_t body_type,
   body->info = NULL;
   body->info_freer = NULL;
   body->flipped = false;
+  body->local_vertices = NULL;
+  body->normals = NULL;
+  body->collision_cache_valid = false;
+  body->collision_kind = SHAPE_POLYGON;
+  body->collision_radius = 0;
+  body->capsule[0] = VEC_ZERO;
+  body->capsule[1] = VEC_ZERO;
+  body->proxy = BODY_NO_PROXY;
+  body->type_index = 0;
+  body->collision_category = 1;
+  body->collision_mask = COLLISION_MASK_ALL;
+  body->sensor = false;
+  body->bullet = false;
+  body->field_scale = 1;
 
   list_t *points = list_init(4, free);
   vector_t *side1 = malloc(sizeof(vector_t));
@@ -105,6 +159,8 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
 
 void body_free(body_t *body) {
   list_free(body->shape);
+  free(body->local_vertices);
+  free(body->normals);
   if (body->info_freer != NULL) {
     body->info_freer(body->info);
   }
@@ -126,6 +182,122 @@ list_t *body_get_shape(body_t *body) {
   return returned;
 }
 
+collision_shape_t body_get_collision_shape(body_t *body) {
+  size_t size;
+  switch (body->collision_kind) {
+  case SHAPE_CIRCLE:
+    size = 1;
+    break;
+  case SHAPE_CAPSULE:
+    size = 2;
+    break;
+  default:
+    size = list_size(body->shape);
+    break;
+  }
+  if (!body->collision_cache_valid) {
+    if (body->local_vertices == NULL) {
+      body->local_vertices = malloc(size * sizeof(vector_t));
+      body->normals = malloc(size * sizeof(vector_t));
+    }
+    for (size_t i = 0; i < size; i++) {
+      if (body->collision_kind == SHAPE_CIRCLE) {
+        body->local_vertices[i] = VEC_ZERO;
+      } else if (body->collision_kind == SHAPE_CAPSULE) {
+        body->local_vertices[i] = body->capsule[i];
+      } else {
+        vector_t *vertex = list_get(body->shape, i);
+        body->local_vertices[i] = vec_subtract(*vertex, body->centroid);
+      }
+    }
+    collision_compute_normals(size, body->local_vertices, body->normals);
+    collision_shape_t local = {size, body->local_vertices, body->normals,
+                               VEC_ZERO, body->collision_kind,
+                               body->collision_radius};
+    body->local_bounds = collision_shape_aabb(&local);
+    body->collision_cache_valid = true;
+  }
+  return (collision_shape_t){size,
+                             body->local_vertices,
+                             body->normals,
+                             body->centroid,
+                             body->collision_kind,
+                             body->collision_radius};
+}
+
+aabb_t body_get_aabb(body_t *body) {
+  if (!body->collision_cache_valid) {
+    body_get_collision_shape(body);
+  }
+  return (aabb_t){vec_add(body->local_bounds.min, body->centroid),
+                  vec_add(body->local_bounds.max, body->centroid)};
+}
+
+size_t body_get_proxy(body_t *body) { return body->proxy; }
+
+void body_set_proxy(body_t *body, size_t proxy) { body->proxy = proxy; }
+
+size_t body_get_type_index(body_t *body) { return body->type_index; }
+
+void body_set_type_index(body_t *body, size_t index) {
+  body->type_index = index;
+}
+
+void body_set_collision_filter(body_t *body, uint32_t category,
+                               uint32_t mask) {
+  body->collision_category = category;
+  body->collision_mask = mask;
+}
+
+uint32_t body_get_collision_category(body_t *body) {
+  return body->collision_category;
+}
+
+uint32_t body_get_collision_mask(body_t *body) { return body->collision_mask; }
+
+void body_set_sensor(body_t *body, bool sensor) { body->sensor = sensor; }
+
+bool body_is_sensor(body_t *body) { return body->sensor; }
+
+void body_set_bullet(body_t *body, bool bullet) { body->bullet = bullet; }
+
+bool body_is_bullet(body_t *body) { return body->bullet; }
+
+void body_set_field_scale(body_t *body, double scale) {
+  body->field_scale = scale;
+}
+
+double body_get_field_scale(body_t *body) { return body->field_scale; }
+
+bool body_filters_collide(body_t *body1, body_t *body2) {
+  return (body1->collision_category & body2->collision_mask) != 0 &&
+         (body2->collision_category & body1->collision_mask) != 0;
+}
+
+/**
+ * Switches the collision primitive of a body and drops its cached shape.
+ */
+void body_set_collision_kind(body_t *body, shape_kind_t kind, double radius) {
+  free(body->local_vertices);
+  free(body->normals);
+  body->local_vertices = NULL;
+  body->normals = NULL;
+  body->collision_cache_valid = false;
+  body->collision_kind = kind;
+  body->collision_radius = radius;
+}
+
+void body_set_circle(body_t *body, double radius) {
+  body_set_collision_kind(body, SHAPE_CIRCLE, radius);
+}
+
+void body_set_capsule(body_t *body, vector_t start, vector_t end,
+                      double radius) {
+  body_set_collision_kind(body, SHAPE_CAPSULE, radius);
+  body->capsule[0] = start;
+  body->capsule[1] = end;
+}
+
 vector_t body_get_centroid(body_t *body) { return body->centroid; }
 
 vector_t body_get_velocity(body_t *body) { return body->velocity; }
@@ -156,6 +328,9 @@ void body_set_rotation(body_t *body, double angle) {
   if (!body->texture) {
     polygon_rotate(body->shape, -(body->angle), body->centroid);
     polygon_rotate(body->shape, angle, body->centroid);
+    body->capsule[0] = vec_rotate(body->capsule[0], angle - body->angle);
+    body->capsule[1] = vec_rotate(body->capsule[1], angle - body->angle);
+    body->collision_cache_valid = false;
   }
   body->angle = angle;
 }
@@ -172,13 +347,21 @@ void body_add_impulse(body_t *body, vector_t impulse) {
 
 void body_set_color(body_t *body, rgb_color_t color) { body->color = color; }
 
-void body_tick(body_t *body, double dt) {
+vector_t body_get_next_velocity(body_t *body, double dt) {
   vector_t acceleration = vec_multiply(1.0 / body->mass, body->force);
-  vector_t curr_vel = body->velocity;
-  vector_t new_vel = vec_add(curr_vel, vec_multiply(dt, acceleration));
-  new_vel = vec_add(new_vel, vec_multiply(1.0 / body->mass, body->impulse));
-  vector_t avg_vel = vec_multiply(0.5, vec_add(curr_vel, new_vel));
-  vector_t dx = vec_multiply(dt, avg_vel);
+  vector_t new_vel = vec_add(body->velocity, vec_multiply(dt, acceleration));
+  return vec_add(new_vel, vec_multiply(1.0 / body->mass, body->impulse));
+}
+
+vector_t body_get_displacement(body_t *body, double dt) {
+  vector_t new_vel = body_get_next_velocity(body, dt);
+  vector_t avg_vel = vec_multiply(0.5, vec_add(body->velocity, new_vel));
+  return vec_multiply(dt, avg_vel);
+}
+
+void body_tick(body_t *body, double dt) {
+  vector_t new_vel = body_get_next_velocity(body, dt);
+  vector_t dx = body_get_displacement(body, dt);
 
   body->centroid = vec_add(body->centroid, dx);
   polygon_translate(body->shape, dx);
@@ -186,8 +369,11 @@ void body_tick(body_t *body, double dt) {
   double rotate = body->angvel * dt;
   body->angle += rotate;
 
-  if (!body->texture) {
+  if (!body->texture && rotate != 0) {
     polygon_rotate(body->shape, rotate, body->centroid);
+    body->capsule[0] = vec_rotate(body->capsule[0], rotate);
+    body->capsule[1] = vec_rotate(body->capsule[1], rotate);
+    body->collision_cache_valid = false;
   }
 
   body->velocity = new_vel;
@@ -0,0 +1,146 @@
+#include "body_table.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct body_table {
+  // the slots, entry_size bytes each; empty slots have a NULL body1
+  char *entries;
+  size_t entry_size;
+  // always a power of 2, at least twice size
+  size_t capacity;
+  size_t size;
+};
+
+body_table_t *body_table_init(size_t entry_size, size_t capacity) {
+  assert(entry_size >= sizeof(body_key_t));
+  assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  body_table_t *table = malloc(sizeof(body_table_t));
+  assert(table);
+  table->entries = calloc(capacity, entry_size);
+  assert(table->entries);
+  table->entry_size = entry_size;
+  table->capacity = capacity;
+  table->size = 0;
+  return table;
+}
+
+void body_table_free(body_table_t *table) {
+  free(table->entries);
+  free(table);
+}
+
+size_t body_table_size(body_table_t *table) { return table->size; }
+
+size_t body_table_capacity(body_table_t *table) { return table->capacity; }
+
+/**
+ * Gets the key at the start of the entry in a slot.
+ */
+body_key_t *body_table_key(body_table_t *table, char *entries, size_t index) {
+  return (body_key_t *)(entries + index * table->entry_size);
+}
+
+/**
+ * Mixes the addresses of the bodies of a key into a slot index.
+ */
+size_t body_table_hash(body_t *body1, body_t *body2) {
+  uint64_t hash = (uint64_t)(uintptr_t)body1 * 0x9E3779B97F4A7C15u;
+  hash ^= (uint64_t)(uintptr_t)body2 + (hash << 6) + (hash >> 2);
+  return (size_t)(hash ^ (hash >> 29));
+}
+
+/**
+ * Finds the slot holding a key, or the empty slot where it would go.
+ */
+size_t body_table_slot(body_table_t *table, char *entries, size_t capacity,
+                       body_t *body1, body_t *body2) {
+  size_t index = body_table_hash(body1, body2) & (capacity - 1);
+  while (true) {
+    body_key_t *key = body_table_key(table, entries, index);
+    if (key->body1 == NULL ||
+        (key->body1 == body1 && key->body2 == body2)) {
+      return index;
+    }
+    index = (index + 1) & (capacity - 1);
+  }
+}
+
+/**
+ * Moves the entries into a new table of the given capacity.
+ */
+void body_table_grow(body_table_t *table, size_t capacity) {
+  char *entries = calloc(capacity, table->entry_size);
+  assert(entries);
+  for (size_t i = 0; i < table->capacity; i++) {
+    body_key_t *key = body_table_key(table, table->entries, i);
+    if (key->body1 != NULL) {
+      size_t slot =
+          body_table_slot(table, entries, capacity, key->body1, key->body2);
+      memcpy(body_table_key(table, entries, slot), key, table->entry_size);
+    }
+  }
+  free(table->entries);
+  table->entries = entries;
+  table->capacity = capacity;
+}
+
+void *body_table_find(body_table_t *table, body_t *body1, body_t *body2) {
+  size_t slot = body_table_slot(table, table->entries, table->capacity, body1,
+                                body2);
+  body_key_t *key = body_table_key(table, table->entries, slot);
+  return key->body1 == NULL ? NULL : key;
+}
+
+void *body_table_add(body_table_t *table, body_t *body1, body_t *body2) {
+  assert(body1 != NULL);
+  size_t slot = body_table_slot(table, table->entries, table->capacity, body1,
+                                body2);
+  body_key_t *key = body_table_key(table, table->entries, slot);
+  if (key->body1 != NULL) {
+    return key;
+  }
+  if (2 * (table->size + 1) > table->capacity) {
+    body_table_grow(table, 2 * table->capacity);
+    slot = body_table_slot(table, table->entries, table->capacity, body1,
+                           body2);
+    key = body_table_key(table, table->entries, slot);
+  }
+  memset(key, 0, table->entry_size);
+  key->body1 = body1;
+  key->body2 = body2;
+  table->size++;
+  return key;
+}
+
+void body_table_remove(body_table_t *table, void *entry) {
+  size_t hole = ((char *)entry - table->entries) / table->entry_size;
+  assert(hole < table->capacity);
+  size_t mask = table->capacity - 1;
+  // shift later entries of the probe sequence back, so that lookups never
+  // stop early at the hole
+  for (size_t j = (hole + 1) & mask;
+       body_table_key(table, table->entries, j)->body1 != NULL;
+       j = (j + 1) & mask) {
+    body_key_t *key = body_table_key(table, table->entries, j);
+    size_t home = body_table_hash(key->body1, key->body2) & mask;
+    // the entry can fill the hole unless its home lies in (hole, j]
+    bool stays = hole <= j ? hole < home && home <= j
+                           : hole < home || home <= j;
+    if (!stays) {
+      memcpy(body_table_key(table, table->entries, hole), key,
+             table->entry_size);
+      hole = j;
+    }
+  }
+  body_table_key(table, table->entries, hole)->body1 = NULL;
+  table->size--;
+}
+
+void *body_table_get_slot(body_table_t *table, size_t index) {
+  assert(index < table->capacity);
+  body_key_t *key = body_table_key(table, table->entries, index);
+  return key->body1 == NULL ? NULL : key;
+}
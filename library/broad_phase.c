@@ -0,0 +1,256 @@
+#include "broad_phase.h"
+#include "aabb_tree.h"
+#include "sweep_and_prune.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// how far fat boxes extend past the bodies' real boxes
+const double BROAD_PHASE_MARGIN = 2;
+// how many ticks of motion fat boxes are stretched to cover
+const double BROAD_PHASE_LOOKAHEAD = 2;
+
+struct broad_phase {
+  broad_phase_kind_t kind;
+  // only the structure matching kind is allocated
+  aabb_tree_t *tree;
+  sweep_and_prune_t *sap;
+};
+
+broad_phase_t *broad_phase_init(broad_phase_kind_t kind) {
+  assert(kind != BROAD_PHASE_NONE);
+  broad_phase_t *broad_phase = malloc(sizeof(broad_phase_t));
+  assert(broad_phase);
+  broad_phase->kind = kind;
+  broad_phase->tree = NULL;
+  broad_phase->sap = NULL;
+  if (kind == BROAD_PHASE_AABB_TREE) {
+    broad_phase->tree = aabb_tree_init(BROAD_PHASE_MARGIN);
+  } else {
+    broad_phase->sap = sweep_and_prune_init(BROAD_PHASE_MARGIN);
+  }
+  return broad_phase;
+}
+
+/**
+ * Calls a function on every proxy, whichever structure is in use.
+ */
+void broad_phase_for_each(broad_phase_t *broad_phase, aabb_query_t callback,
+                          void *aux) {
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_for_each(broad_phase->tree, callback, aux);
+  } else {
+    sweep_and_prune_for_each(broad_phase->sap, callback, aux);
+  }
+}
+
+/**
+ * Forgets the proxy of a body that is being dropped with its broad phase.
+ */
+bool broad_phase_release(size_t proxy, void *data, void *aux) {
+  (void)proxy;
+  (void)aux;
+  body_set_proxy(data, BODY_NO_PROXY);
+  return true;
+}
+
+void broad_phase_free(broad_phase_t *broad_phase) {
+  broad_phase_for_each(broad_phase, broad_phase_release, NULL);
+  if (broad_phase->tree != NULL) {
+    aabb_tree_free(broad_phase->tree);
+  }
+  if (broad_phase->sap != NULL) {
+    sweep_and_prune_free(broad_phase->sap);
+  }
+  free(broad_phase);
+}
+
+broad_phase_kind_t broad_phase_get_kind(broad_phase_t *broad_phase) {
+  return broad_phase->kind;
+}
+
+void broad_phase_add(broad_phase_t *broad_phase, body_t *body) {
+  assert(body_get_proxy(body) == BODY_NO_PROXY);
+  aabb_t aabb = body_get_aabb(body);
+  size_t proxy;
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    proxy = aabb_tree_insert(broad_phase->tree, aabb, body);
+  } else {
+    proxy = sweep_and_prune_insert(broad_phase->sap, aabb, body);
+  }
+  body_set_proxy(body, proxy);
+}
+
+void broad_phase_remove(broad_phase_t *broad_phase, body_t *body) {
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_remove(broad_phase->tree, body_get_proxy(body));
+  } else {
+    sweep_and_prune_remove(broad_phase->sap, body_get_proxy(body));
+  }
+  body_set_proxy(body, BODY_NO_PROXY);
+}
+
+void broad_phase_update_body(broad_phase_t *broad_phase, body_t *body,
+                             double dt) {
+  size_t proxy = body_get_proxy(body);
+  aabb_t aabb = body_get_aabb(body);
+  if (body_is_bullet(body)) {
+    aabb = aabb_expand(aabb, 0, body_get_displacement(body, dt));
+  }
+  vector_t displacement =
+      vec_multiply(BROAD_PHASE_LOOKAHEAD * dt, body_get_velocity(body));
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_move(broad_phase->tree, proxy, aabb, displacement);
+  } else {
+    sweep_and_prune_move(broad_phase->sap, proxy, aabb, displacement);
+  }
+}
+
+typedef struct {
+  broad_phase_t *broad_phase;
+  double dt;
+} update_pass_t;
+
+/**
+ * Moves a body's proxy to its current box, anticipating its motion.
+ */
+bool broad_phase_move(size_t proxy, void *data, void *aux) {
+  (void)proxy;
+  update_pass_t *pass = aux;
+  broad_phase_update_body(pass->broad_phase, data, pass->dt);
+  return true;
+}
+
+void broad_phase_update(broad_phase_t *broad_phase, double dt) {
+  update_pass_t pass = {broad_phase, dt};
+  broad_phase_for_each(broad_phase, broad_phase_move, &pass);
+}
+
+/**
+ * Gets the fat box of a proxy, whichever structure is in use.
+ */
+aabb_t broad_phase_get_fat_aabb(broad_phase_t *broad_phase, size_t proxy) {
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    return aabb_tree_get_fat_aabb(broad_phase->tree, proxy);
+  }
+  return sweep_and_prune_get_fat_aabb(broad_phase->sap, proxy);
+}
+
+bool broad_phase_test_overlap(broad_phase_t *broad_phase, body_t *body1,
+                              body_t *body2) {
+  size_t proxy1 = body_get_proxy(body1);
+  size_t proxy2 = body_get_proxy(body2);
+  if (proxy1 == BODY_NO_PROXY || proxy2 == BODY_NO_PROXY) {
+    return true;
+  }
+  return aabb_overlap(broad_phase_get_fat_aabb(broad_phase, proxy1),
+                      broad_phase_get_fat_aabb(broad_phase, proxy2));
+}
+
+typedef struct {
+  broad_phase_t *broad_phase;
+  body_pair_handler_t handler;
+  void *aux;
+  // the proxy whose partners are being found
+  size_t proxy;
+  body_t *body;
+} pair_search_t;
+
+/**
+ * Reports a partner of the proxy being searched.
+ * Each pair is found from both of its proxies, so only the search from
+ * the lower proxy reports it.
+ */
+bool broad_phase_report_pair(size_t proxy, void *data, void *aux) {
+  pair_search_t *search = aux;
+  if (proxy > search->proxy) {
+    search->handler(search->body, data, search->aux);
+  }
+  return true;
+}
+
+/**
+ * Finds the partners of one proxy in the tree.
+ */
+bool broad_phase_search_proxy(size_t proxy, void *data, void *aux) {
+  pair_search_t *search = aux;
+  search->proxy = proxy;
+  search->body = data;
+  aabb_tree_t *tree = search->broad_phase->tree;
+  aabb_tree_query(tree, aabb_tree_get_fat_aabb(tree, proxy),
+                  broad_phase_report_pair, search);
+  return true;
+}
+
+/**
+ * Passes a pair found by the sweep on to the body pair handler.
+ */
+void broad_phase_report_sweep_pair(void *data1, void *data2, void *aux) {
+  pair_search_t *search = aux;
+  search->handler(data1, data2, search->aux);
+}
+
+void broad_phase_find_pairs(broad_phase_t *broad_phase,
+                            body_pair_handler_t handler, void *aux) {
+  pair_search_t search = {broad_phase, handler, aux, BODY_NO_PROXY, NULL};
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_for_each(broad_phase->tree, broad_phase_search_proxy, &search);
+  } else {
+    sweep_and_prune_find_pairs(broad_phase->sap, broad_phase_report_sweep_pair,
+                               &search);
+  }
+}
+
+typedef struct {
+  body_query_handler_t handler;
+  void *aux;
+} body_query_t;
+
+bool broad_phase_report_body(size_t proxy, void *data, void *aux) {
+  (void)proxy;
+  body_query_t *query = aux;
+  return query->handler(data, query->aux);
+}
+
+void broad_phase_query(broad_phase_t *broad_phase, aabb_t aabb,
+                       body_query_handler_t handler, void *aux) {
+  body_query_t query = {handler, aux};
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_query(broad_phase->tree, aabb, broad_phase_report_body, &query);
+  } else {
+    sweep_and_prune_query(broad_phase->sap, aabb, broad_phase_report_body,
+                          &query);
+  }
+}
+
+typedef struct {
+  sweep_and_prune_t *sap;
+  vector_t origin;
+  vector_t translation;
+  body_query_t query;
+} sweep_raycast_t;
+
+bool broad_phase_report_crossed_body(size_t proxy, void *data, void *aux) {
+  sweep_raycast_t *raycast = aux;
+  aabb_t fat = sweep_and_prune_get_fat_aabb(raycast->sap, proxy);
+  if (!aabb_ray_overlap(fat, raycast->origin, raycast->translation)) {
+    return true;
+  }
+  return broad_phase_report_body(proxy, data, &raycast->query);
+}
+
+void broad_phase_raycast(broad_phase_t *broad_phase, vector_t origin,
+                         vector_t translation, body_query_handler_t handler,
+                         void *aux) {
+  body_query_t query = {handler, aux};
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_raycast(broad_phase->tree, origin, translation,
+                      broad_phase_report_body, &query);
+  } else {
+    // the sorted axis only narrows the search to the segment's box
+    sweep_raycast_t raycast = {broad_phase->sap, origin, translation, query};
+    aabb_t bounds = {origin, origin};
+    bounds = aabb_expand(bounds, 0, translation);
+    sweep_and_prune_query(broad_phase->sap, bounds,
+                          broad_phase_report_crossed_body, &raycast);
+  }
+}
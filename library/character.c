@@ -0,0 +1,192 @@
+#include "character.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t CHARACTER_INITIAL_OBSTACLES = 16;
+// the most surfaces the character slides along in one tick
+const size_t CHARACTER_MAX_SLIDES = 4;
+// how far up a surface's normal must point for it to count as a floor
+const double CHARACTER_FLOOR_MIN_NORMAL = 0.7;
+// how far sideways a surface's normal must point for it to count as a wall
+const double CHARACTER_WALL_MIN_NORMAL = 0.7;
+// the gap left between the character and the surfaces it stops at; without
+// it, the character would catch on the corners where two flush tiles meet
+const double CHARACTER_SKIN = 0.01;
+
+typedef struct {
+  // the normal of the surface, pointing out of the obstacle
+  vector_t normal;
+  // the velocity of the obstacle when it was hit
+  vector_t velocity;
+} character_contact_t;
+
+struct character {
+  body_t *body;
+  uint32_t solid_categories;
+  body_t **obstacles;
+  size_t obstacle_count;
+  size_t obstacle_capacity;
+  // the surfaces hit by the last sweep, at most CHARACTER_MAX_SLIDES
+  character_contact_t *contacts;
+  size_t contact_count;
+  // where the body ends the tick, once character_sweep() has run
+  vector_t target;
+  bool swept;
+  bool grounded;
+  bool against_wall;
+};
+
+character_t *character_init(body_t *body, uint32_t solid_categories) {
+  character_t *character = malloc(sizeof(character_t));
+  assert(character);
+  character->body = body;
+  character->solid_categories = solid_categories;
+  character->obstacle_capacity = CHARACTER_INITIAL_OBSTACLES;
+  character->obstacles =
+      malloc(character->obstacle_capacity * sizeof(body_t *));
+  assert(character->obstacles);
+  character->obstacle_count = 0;
+  character->contacts =
+      malloc(CHARACTER_MAX_SLIDES * sizeof(character_contact_t));
+  assert(character->contacts);
+  character->contact_count = 0;
+  character->target = VEC_ZERO;
+  character->swept = false;
+  character->grounded = false;
+  character->against_wall = false;
+  return character;
+}
+
+void character_free(character_t *character) {
+  free(character->obstacles);
+  free(character->contacts);
+  free(character);
+}
+
+body_t *character_get_body(character_t *character) { return character->body; }
+
+bool character_is_grounded(character_t *character) {
+  return character->grounded;
+}
+
+bool character_is_against_wall(character_t *character) {
+  return character->against_wall;
+}
+
+void character_add_obstacle(character_t *character, body_t *obstacle) {
+  if (obstacle == character->body || body_is_sensor(obstacle) ||
+      body_is_removed(obstacle) ||
+      (body_get_collision_category(obstacle) & character->solid_categories) ==
+          0) {
+    return;
+  }
+  if (character->obstacle_count == character->obstacle_capacity) {
+    character->obstacle_capacity *= 2;
+    character->obstacles =
+        realloc(character->obstacles,
+                character->obstacle_capacity * sizeof(body_t *));
+    assert(character->obstacles);
+  }
+  character->obstacles[character->obstacle_count++] = obstacle;
+}
+
+/**
+ * Remembers a surface the character hit and whether it is a floor or wall.
+ */
+void character_add_contact(character_t *character, vector_t normal,
+                           vector_t velocity) {
+  character->contacts[character->contact_count++] =
+      (character_contact_t){normal, velocity};
+  if (normal.y >= CHARACTER_FLOOR_MIN_NORMAL) {
+    character->grounded = true;
+  }
+  if (fabs(normal.x) >= CHARACTER_WALL_MIN_NORMAL) {
+    character->against_wall = true;
+  }
+}
+
+void character_sweep(character_t *character, double dt) {
+  body_t *body = character->body;
+  collision_shape_t shape = body_get_collision_shape(body);
+  vector_t position = shape.centroid;
+  vector_t motion = body_get_displacement(body, dt);
+  // the fraction of the tick the character has already moved through
+  double time = 0;
+  character->contact_count = 0;
+  character->grounded = false;
+  character->against_wall = false;
+
+  for (size_t slide = 0; slide < CHARACTER_MAX_SLIDES; slide++) {
+    // find the first obstacle in the way over the rest of the tick
+    shape.centroid = position;
+    double first = 1;
+    body_t *hit = NULL;
+    vector_t normal = VEC_ZERO;
+    vector_t hit_motion = VEC_ZERO;
+    for (size_t i = 0; i < character->obstacle_count; i++) {
+      body_t *obstacle = character->obstacles[i];
+      vector_t displacement = body_get_displacement(obstacle, dt);
+      collision_shape_t other = body_get_collision_shape(obstacle);
+      other.centroid =
+          vec_add(other.centroid, vec_multiply(time, displacement));
+      vector_t remaining = vec_multiply(1 - time, displacement);
+      time_of_impact_t impact =
+          find_time_of_impact(&shape, motion, &other, remaining);
+      if (!impact.hit || impact.time >= first) {
+        continue;
+      }
+      // surfaces the character is already moving away from do not stop it
+      vector_t surface = vec_negate(impact.axis);
+      if (vec_dot(vec_subtract(motion, remaining), surface) >= 0) {
+        continue;
+      }
+      first = impact.time;
+      hit = obstacle;
+      normal = surface;
+      hit_motion = remaining;
+    }
+    if (hit == NULL) {
+      position = vec_add(position, motion);
+      break;
+    }
+
+    // move up to the surface, then slide the rest of the way along it
+    position = vec_add(position, vec_multiply(first, motion));
+    position = vec_add(position, vec_multiply(CHARACTER_SKIN, normal));
+    vector_t obstacle_left = vec_multiply(1 - first, hit_motion);
+    vector_t relative =
+        vec_subtract(vec_multiply(1 - first, motion), obstacle_left);
+    relative = vec_subtract(relative,
+                            vec_multiply(vec_dot(relative, normal), normal));
+    motion = vec_add(relative, obstacle_left);
+    time += (1 - time) * first;
+    character_add_contact(character, normal, body_get_velocity(hit));
+  }
+
+  character->target = position;
+  character->swept = true;
+  character->obstacle_count = 0;
+}
+
+void character_finish(character_t *character) {
+  if (!character->swept) {
+    return;
+  }
+  character->swept = false;
+  body_t *body = character->body;
+  body_set_centroid(body, character->target);
+
+  // stop moving into the surfaces that were hit, relative to their motion
+  vector_t velocity = body_get_velocity(body);
+  for (size_t i = 0; i < character->contact_count; i++) {
+    character_contact_t *contact = &character->contacts[i];
+    vector_t relative = vec_subtract(velocity, contact->velocity);
+    double into = vec_dot(relative, contact->normal);
+    if (into < 0) {
+      velocity =
+          vec_subtract(velocity, vec_multiply(into, contact->normal));
+    }
+  }
+  body_set_velocity(body, velocity);
+}
@@ -1,58 +1,204 @@
 #include "collision.h"
 #include "polygon.h"
 #include "scene.h"
+#include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_DISPATCH
+#endif
 
 typedef struct {
   double min;
   double max;
 } proj_extrema_t;
 
+// Polygons with at least this many vertices are projected with SIMD
+const size_t SIMD_PROJECTION_MIN_SIZE = 8;
+// Polygons with more vertices than this find support points by hill climbing
+const size_t HILL_CLIMB_MIN_SIZE = 8;
+const size_t GJK_MAX_ITERATIONS = 32;
+// an enum, since a const size_t would make the EPA polytope a VLA
+enum { EPA_MAX_VERTICES = 64 };
+const double EPA_TOLERANCE = 1e-9;
+const size_t TOI_MAX_ITERATIONS = 32;
+const double TOI_TOLERANCE = 1e-3;
+// shapes still this close when the steps run out are reported as touching
+const double TOI_UNCONVERGED_TOLERANCE = 1e-2;
+// how much better the second shape's edge must face the first shape's to be
+// the reference edge, so the choice does not flicker between ticks
+const double MANIFOLD_FACE_TOLERANCE = 1e-3;
+
+/**
+ * A vertex of the Minkowski difference shape2 - shape1, remembering which
+ * vertices of the two shapes produced it.
+ */
+typedef struct {
+  vector_t w;
+  size_t index1;
+  size_t index2;
+  double weight; // barycentric weight in the simplex
+} gjk_vertex_t;
+
+/**
+ * A kernel computing the extrema of the dot products of an array of
+ * vertices with an axis. All kernels return exactly the same result.
+ */
+typedef proj_extrema_t (*projection_kernel_t)(const vector_t *vertices,
+                                              size_t size, vector_t axis);
+
 // Function Prototypes
-collision_info_t find_collision_helper(list_t *shape1, list_t *shape2);
-proj_extrema_t project_vertices(list_t *vertices, vector_t axis);
+collision_info_t find_collision_helper(const collision_shape_t *shape1,
+                                       const collision_shape_t *shape2,
+                                       size_t *separating_edge);
+collision_info_t orient_axis(collision_info_t info,
+                             const collision_shape_t *shape1,
+                             const collision_shape_t *shape2);
+collision_info_t find_rounded_collision(const collision_shape_t *shape1,
+                                        const collision_shape_t *shape2);
+collision_info_t find_circle_collision(const collision_shape_t *shape1,
+                                       const collision_shape_t *shape2);
+double axis_overlap(const collision_shape_t *shape1,
+                    const collision_shape_t *shape2, vector_t axis);
+vector_t closest_point(const collision_shape_t *shape, vector_t point);
+proj_extrema_t project_vertices(const collision_shape_t *shape, vector_t axis);
+proj_extrema_t project_scalar(const vector_t *vertices, size_t size,
+                              vector_t axis);
+projection_kernel_t projection_kernel(void);
+void box_batch_scalar(box_batch_t *batch, size_t start);
+size_t support_index(const collision_shape_t *shape, vector_t direction,
+                     size_t start);
+gjk_vertex_t gjk_support(const collision_shape_t *shape1,
+                         const collision_shape_t *shape2, vector_t direction,
+                         size_t *hint1, size_t *hint2);
+size_t gjk_solve(gjk_vertex_t *simplex, size_t count);
+collision_info_t epa(const collision_shape_t *shape1,
+                     const collision_shape_t *shape2, gjk_vertex_t *simplex,
+                     size_t *hint1, size_t *hint2);
 double vec_length(vector_t vec);
 vector_t vec_normalize(vector_t vec);
 
 collision_info_t find_collision(list_t *shape1, list_t *shape2) {
-  collision_info_t one = find_collision_helper(shape1, shape2);
-  collision_info_t two = find_collision_helper(shape2, shape1);
-  vector_t axis = VEC_ZERO;
-  bool collided = false;
-  if (one.da_overlap < two.da_overlap) {
-    axis = one.axis;
-  } else {
-    axis = two.axis;
+  size_t size1 = list_size(shape1);
+  size_t size2 = list_size(shape2);
+  vector_t *vertices = malloc((size1 + size2) * sizeof(vector_t));
+  vector_t *normals = malloc((size1 + size2) * sizeof(vector_t));
+
+  vector_t centroid1 = polygon_centroid(shape1);
+  for (size_t i = 0; i < size1; i++) {
+    vertices[i] = vec_subtract(*(vector_t *)list_get(shape1, i), centroid1);
+  }
+  vector_t centroid2 = polygon_centroid(shape2);
+  for (size_t i = 0; i < size2; i++) {
+    vertices[size1 + i] =
+        vec_subtract(*(vector_t *)list_get(shape2, i), centroid2);
   }
-  collided = !(one.collided == false || two.collided == false);
-  collision_info_t returned = {collided, axis, 0};
+  collision_compute_normals(size1, vertices, normals);
+  collision_compute_normals(size2, vertices + size1, normals + size1);
+
+  collision_shape_t one = {size1,     vertices,      normals,
+                           centroid1, SHAPE_POLYGON, 0};
+  collision_shape_t two = {size2,     vertices + size1, normals + size1,
+                           centroid2, SHAPE_POLYGON,    0};
+  collision_info_t returned = find_shape_collision(&one, &two);
+
+  free(vertices);
+  free(normals);
   return returned;
 }
 
-collision_info_t find_collision_helper(list_t *shape1, list_t *shape2) {
-  double da_overlap = INFINITY;
-  vector_t da_axis = VEC_ZERO;
-  int collision_check = 1;
+collision_info_t find_shape_collision(const collision_shape_t *shape1,
+                                      const collision_shape_t *shape2) {
+  return find_shape_collision_cached(shape1, shape2, NULL);
+}
+
+collision_info_t find_shape_collision_cached(const collision_shape_t *shape1,
+                                             const collision_shape_t *shape2,
+                                             separating_axis_cache_t *cache) {
+  if (shape1->kind == SHAPE_CIRCLE && shape2->kind == SHAPE_CIRCLE) {
+    return find_circle_collision(shape1, shape2);
+  }
+  if (shape1->kind != SHAPE_POLYGON || shape2->kind != SHAPE_POLYGON) {
+    if (cache != NULL) {
+      cache->shape = 0;
+    }
+    return orient_axis(find_rounded_collision(shape1, shape2), shape1,
+                       shape2);
+  }
 
-  for (size_t i = 0; i < list_size(shape1); i++) { // for each edge
-    vector_t *v1 = list_get(shape1, i);
-    vector_t *v2 = list_get(shape1, (i + 1) % list_size(shape1));
+  // try last tick's separating axis first
+  if (cache != NULL && cache->shape != 0) {
+    const collision_shape_t *owner = cache->shape == 1 ? shape1 : shape2;
+    if (cache->edge < owner->size) {
+      vector_t axis = owner->normals[cache->edge];
+      double overlap = axis_overlap(shape1, shape2, axis);
+      if (overlap <= 0) {
+        collision_info_t returned = {false, axis, overlap};
+        return orient_axis(returned, shape1, shape2);
+      }
+    }
+  }
 
-    vector_t edge = vec_subtract(*v2, *v1);
-    vector_t axis = {edge.y, -edge.x};
+  size_t edge;
+  collision_info_t returned = find_collision_helper(shape1, shape2, &edge);
+  int owner = 1;
+  if (returned.collided) {
+    collision_info_t two = find_collision_helper(shape2, shape1, &edge);
+    if (!two.collided || two.da_overlap < returned.da_overlap) {
+      returned = two;
+    }
+    owner = 2;
+  }
 
-    proj_extrema_t poly1 = project_vertices(shape1, axis);
-    proj_extrema_t poly2 = project_vertices(shape2, axis);
+  if (cache != NULL) {
+    cache->shape = returned.collided ? 0 : owner;
+    cache->edge = edge;
+  }
+  return orient_axis(returned, shape1, shape2);
+}
+
+/**
+ * Flips the axis if needed so it points from shape1 towards shape2.
+ */
+collision_info_t orient_axis(collision_info_t info,
+                             const collision_shape_t *shape1,
+                             const collision_shape_t *shape2) {
+  vector_t direction = vec_subtract(shape2->centroid, shape1->centroid);
+  if (vec_dot(direction, info.axis) < 0) {
+    info.axis = vec_negate(info.axis);
+  }
+  return info;
+}
+
+/**
+ * Runs SAT over the edge normals of shape1.
+ * Stops at the first separating axis, reporting the gap along it as a
+ * negative overlap and its index through separating_edge; otherwise reports
+ * the axis of least overlap.
+ * The returned axis is not oriented.
+ */
+collision_info_t find_collision_helper(const collision_shape_t *shape1,
+                                       const collision_shape_t *shape2,
+                                       size_t *separating_edge) {
+  double da_overlap = INFINITY;
+  vector_t da_axis = VEC_ZERO;
 
-    if (poly1.min >= poly2.max || poly2.min >= poly1.max) {
-      collision_check = 0; // axis of separation exists, no collision
-      break;               // should break out of the for loop
+  for (size_t i = 0; i < shape1->size; i++) { // for each edge
+    vector_t axis = shape1->normals[i];
+    if (axis.x == 0 && axis.y == 0) {
+      continue; // degenerate edge
     }
-    double overlap = poly2.max - poly1.min;
-    if (poly1.max - poly2.min < overlap) {
-      overlap = poly1.max - poly2.min;
+
+    double overlap = axis_overlap(shape1, shape2, axis);
+    if (overlap <= 0) {
+      // axis of separation exists, no collision
+      *separating_edge = i;
+      return (collision_info_t){false, axis, overlap};
     }
     if (overlap < da_overlap) {
       da_overlap = overlap;
@@ -60,38 +206,152 @@ collision_info_t find_collision_helper(list_t *shape1, list_t *shape2) {
     }
   }
 
-  da_overlap /= vec_length(da_axis); // to get the actual overlap
-  da_axis = vec_normalize(da_axis);
+  return (collision_info_t){true, da_axis, da_overlap};
+}
 
-  // to ensure that da_axis is in the correct direction, point from shape1 to
-  // shape2
-  vector_t shape1_centroid = polygon_centroid(shape1);
-  vector_t shape2_centroid = polygon_centroid(shape2);
-  vector_t direction = vec_subtract(shape2_centroid, shape1_centroid);
+/**
+ * Tests two circles by the distance between their centers.
+ */
+collision_info_t find_circle_collision(const collision_shape_t *shape1,
+                                       const collision_shape_t *shape2) {
+  vector_t center1 = vec_add(shape1->centroid, shape1->vertices[0]);
+  vector_t center2 = vec_add(shape2->centroid, shape2->vertices[0]);
+  vector_t direction = vec_subtract(center2, center1);
+  double dist = vec_length(direction);
+  double radii = shape1->radius + shape2->radius;
+  vector_t axis = dist > 0 ? vec_multiply(1 / dist, direction)
+                           : (vector_t){0, 1}; // concentric, pick any axis
+  return (collision_info_t){dist < radii, axis, radii - dist};
+}
 
-  if (vec_dot(direction, da_axis) < 0) {
-    da_axis = vec_negate(da_axis);
+/**
+ * Runs SAT on shapes where at least one is rounded.
+ * Besides the edge normals of both cores, the closest features of a rounded
+ * shape and the other shape are separated along the line from each core
+ * vertex to the nearest point of the other core, so those axes are tested
+ * too. The returned axis is not oriented.
+ */
+collision_info_t find_rounded_collision(const collision_shape_t *shape1,
+                                        const collision_shape_t *shape2) {
+  size_t edge;
+  collision_info_t returned = find_collision_helper(shape1, shape2, &edge);
+  if (!returned.collided) {
+    return returned;
+  }
+  collision_info_t two = find_collision_helper(shape2, shape1, &edge);
+  if (!two.collided || two.da_overlap < returned.da_overlap) {
+    returned = two;
+    if (!returned.collided) {
+      return returned;
+    }
   }
 
-  collision_info_t returned = {collision_check == 1 ? true : false, da_axis,
-                               da_overlap};
+  const collision_shape_t *shapes[2] = {shape1, shape2};
+  for (size_t s = 0; s < 2; s++) {
+    const collision_shape_t *rounded = shapes[s];
+    const collision_shape_t *other = shapes[1 - s];
+    if (rounded->radius == 0) {
+      continue;
+    }
+    for (size_t i = 0; i < rounded->size; i++) {
+      vector_t vertex = vec_add(rounded->centroid, rounded->vertices[i]);
+      vector_t axis = vec_subtract(vertex, closest_point(other, vertex));
+      double length = vec_length(axis);
+      if (length == 0) {
+        continue; // vertex lies on the other core
+      }
+      axis = vec_multiply(1 / length, axis);
+      double overlap = axis_overlap(shape1, shape2, axis);
+      if (overlap <= 0) {
+        return (collision_info_t){false, axis, overlap};
+      }
+      if (overlap < returned.da_overlap) {
+        returned.da_overlap = overlap;
+        returned.axis = axis;
+      }
+    }
+  }
   return returned;
 }
 
 /**
- * Projects the vectors in vertices to the axis.
- * @param vertices the vertices
- * @param axis the axis to project onto (axis is perpendicular to an edge of
- * polygon)
- * @return {min, max} the minimum and maximum projection as a vector_t
+ * Computes how far the projections of two shapes onto an axis overlap,
+ * including the radius of rounded shapes.
+ * @return the overlap, or the negated gap if the projections are disjoint
+ */
+double axis_overlap(const collision_shape_t *shape1,
+                    const collision_shape_t *shape2, vector_t axis) {
+  proj_extrema_t poly1 = project_vertices(shape1, axis);
+  proj_extrema_t poly2 = project_vertices(shape2, axis);
+
+  double overlap = poly2.max - poly1.min;
+  if (poly1.max - poly2.min < overlap) {
+    overlap = poly1.max - poly2.min;
+  }
+  return overlap;
+}
+
+/**
+ * Finds the point on the boundary of a shape's core closest to a point.
+ * @param shape the shape (its radius is ignored)
+ * @param point the point, in absolute coordinates
+ * @return the closest point, in absolute coordinates
  */
-proj_extrema_t project_vertices(list_t *vertices, vector_t axis) {
+vector_t closest_point(const collision_shape_t *shape, vector_t point) {
+  vector_t local = vec_subtract(point, shape->centroid);
+  if (shape->size == 1) {
+    return vec_add(shape->centroid, shape->vertices[0]);
+  }
+  vector_t best = shape->vertices[0];
+  double best_dist = INFINITY;
+  // a segment has the same edge twice, so only check it once
+  size_t edges = shape->size == 2 ? 1 : shape->size;
+  for (size_t i = 0; i < edges; i++) {
+    vector_t a = shape->vertices[i];
+    vector_t edge = vec_subtract(shape->vertices[(i + 1) % shape->size], a);
+    double length = vec_dot(edge, edge);
+    double t = length > 0 ? vec_dot(vec_subtract(local, a), edge) / length : 0;
+    t = fmax(0, fmin(1, t));
+    vector_t candidate = vec_add(a, vec_multiply(t, edge));
+    vector_t diff = vec_subtract(local, candidate);
+    double dist = vec_dot(diff, diff);
+    if (dist < best_dist) {
+      best_dist = dist;
+      best = candidate;
+    }
+  }
+  return vec_add(shape->centroid, best);
+}
+
+/**
+ * Projects a shape to the axis, including its radius.
+ * @param shape the shape
+ * @param axis the unit axis to project onto
+ * @return {min, max} the minimum and maximum projection
+ */
+proj_extrema_t project_vertices(const collision_shape_t *shape, vector_t axis) {
+  proj_extrema_t extrema;
+  if (shape->size >= SIMD_PROJECTION_MIN_SIZE) {
+    extrema = projection_kernel()(shape->vertices, shape->size, axis);
+  } else {
+    extrema = project_scalar(shape->vertices, shape->size, axis);
+  }
+  double offset = vec_dot(shape->centroid, axis);
+  return (proj_extrema_t){extrema.min + offset - shape->radius,
+                          extrema.max + offset + shape->radius};
+}
+
+/**
+ * Projects vertices one at a time. Used for small polygons and as the
+ * fallback when no SIMD kernel is available.
+ */
+proj_extrema_t project_scalar(const vector_t *vertices, size_t size,
+                              vector_t axis) {
   double min = INFINITY;
   double max = -INFINITY;
 
-  for (size_t i = 0; i < list_size(vertices); i++) {
-    vector_t *vertex = list_get(vertices, i);
-    double projection = vec_dot(*vertex, axis);
+  for (size_t i = 0; i < size; i++) {
+    double projection = vec_dot(vertices[i], axis);
 
     if (projection < min) {
       min = projection;
@@ -103,8 +363,942 @@ proj_extrema_t project_vertices(list_t *vertices, vector_t axis) {
   return (proj_extrema_t){min, max};
 }
 
-double vec_length(vector_t vec) { return sqrt(pow(vec.x, 2) + pow(vec.y, 2)); }
+#ifdef __SSE2__
+/**
+ * Projects 4 vertices per iteration. vector_t stores x and y next to each
+ * other, so each 128-bit load is one vertex; pairs of them are unpacked into
+ * an x register and a y register before the dot products.
+ */
+proj_extrema_t project_sse2(const vector_t *vertices, size_t size,
+                            vector_t axis) {
+  const double *coords = (const double *)vertices;
+  __m128d ax = _mm_set1_pd(axis.x);
+  __m128d ay = _mm_set1_pd(axis.y);
+  __m128d min = _mm_set1_pd(INFINITY);
+  __m128d max = _mm_set1_pd(-INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    __m128d v0 = _mm_loadu_pd(coords + 2 * i);
+    __m128d v1 = _mm_loadu_pd(coords + 2 * i + 2);
+    __m128d v2 = _mm_loadu_pd(coords + 2 * i + 4);
+    __m128d v3 = _mm_loadu_pd(coords + 2 * i + 6);
+    __m128d dot01 = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(v0, v1), ax),
+                               _mm_mul_pd(_mm_unpackhi_pd(v0, v1), ay));
+    __m128d dot23 = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(v2, v3), ax),
+                               _mm_mul_pd(_mm_unpackhi_pd(v2, v3), ay));
+    min = _mm_min_pd(min, _mm_min_pd(dot01, dot23));
+    max = _mm_max_pd(max, _mm_max_pd(dot01, dot23));
+  }
+  double mins[2];
+  double maxs[2];
+  _mm_storeu_pd(mins, min);
+  _mm_storeu_pd(maxs, max);
+
+  proj_extrema_t tail = project_scalar(vertices + i, size - i, axis);
+  return (proj_extrema_t){fmin(fmin(mins[0], mins[1]), tail.min),
+                          fmax(fmax(maxs[0], maxs[1]), tail.max)};
+}
+#endif
+
+#ifdef HAVE_AVX2_DISPATCH
+/**
+ * Projects 8 vertices per iteration. Each 256-bit load holds two vertices;
+ * the in-lane unpacks give the x and y coordinates of four vertices (in a
+ * shuffled order, which does not matter for the extrema).
+ * FMA is deliberately not used so the results match the scalar kernel.
+ */
+__attribute__((target("avx2"))) proj_extrema_t
+project_avx2(const vector_t *vertices, size_t size, vector_t axis) {
+  const double *coords = (const double *)vertices;
+  __m256d ax = _mm256_set1_pd(axis.x);
+  __m256d ay = _mm256_set1_pd(axis.y);
+  __m256d min = _mm256_set1_pd(INFINITY);
+  __m256d max = _mm256_set1_pd(-INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256d v01 = _mm256_loadu_pd(coords + 2 * i);
+    __m256d v23 = _mm256_loadu_pd(coords + 2 * i + 4);
+    __m256d v45 = _mm256_loadu_pd(coords + 2 * i + 8);
+    __m256d v67 = _mm256_loadu_pd(coords + 2 * i + 12);
+    __m256d dot0123 =
+        _mm256_add_pd(_mm256_mul_pd(_mm256_unpacklo_pd(v01, v23), ax),
+                      _mm256_mul_pd(_mm256_unpackhi_pd(v01, v23), ay));
+    __m256d dot4567 =
+        _mm256_add_pd(_mm256_mul_pd(_mm256_unpacklo_pd(v45, v67), ax),
+                      _mm256_mul_pd(_mm256_unpackhi_pd(v45, v67), ay));
+    min = _mm256_min_pd(min, _mm256_min_pd(dot0123, dot4567));
+    max = _mm256_max_pd(max, _mm256_max_pd(dot0123, dot4567));
+  }
+  double mins[4];
+  double maxs[4];
+  _mm256_storeu_pd(mins, min);
+  _mm256_storeu_pd(maxs, max);
+
+  proj_extrema_t tail = project_scalar(vertices + i, size - i, axis);
+  for (size_t j = 0; j < 4; j++) {
+    tail.min = fmin(tail.min, mins[j]);
+    tail.max = fmax(tail.max, maxs[j]);
+  }
+  return tail;
+}
+#endif
+
+/**
+ * Picks the widest projection kernel the CPU supports, checking only once.
+ */
+projection_kernel_t projection_kernel(void) {
+  static projection_kernel_t kernel = NULL;
+  if (kernel == NULL) {
+    kernel = project_scalar;
+#ifdef __SSE2__
+    kernel = project_sse2;
+#endif
+#ifdef HAVE_AVX2_DISPATCH
+    if (__builtin_cpu_supports("avx2")) {
+      kernel = project_avx2;
+    }
+#endif
+  }
+  return kernel;
+}
+
+void collision_compute_normals(size_t size, const vector_t *vertices,
+                               vector_t *normals) {
+  for (size_t i = 0; i < size; i++) {
+    vector_t edge = vec_subtract(vertices[(i + 1) % size], vertices[i]);
+    if (edge.x == 0 && edge.y == 0) {
+      normals[i] = VEC_ZERO;
+    } else {
+      normals[i] = vec_normalize((vector_t){edge.y, -edge.x});
+    }
+  }
+}
+
+collision_info_t find_shape_collision_with(narrow_phase_t narrow_phase,
+                                           const collision_shape_t *shape1,
+                                           const collision_shape_t *shape2,
+                                           separating_axis_cache_t *cache) {
+  if (narrow_phase == NARROW_PHASE_GJK) {
+    return find_shape_collision_gjk(shape1, shape2);
+  }
+  return find_shape_collision_cached(shape1, shape2, cache);
+}
+
+collision_info_t find_shape_collision_gjk(const collision_shape_t *shape1,
+                                          const collision_shape_t *shape2) {
+  double radii = shape1->radius + shape2->radius;
+  size_t hint1 = 0;
+  size_t hint2 = 0;
+  gjk_vertex_t simplex[3];
+  vector_t start = vec_subtract(shape2->centroid, shape1->centroid);
+  if (start.x == 0 && start.y == 0) {
+    start = (vector_t){1, 0};
+  }
+  simplex[0] = gjk_support(shape1, shape2, start, &hint1, &hint2);
+  simplex[0].weight = 1;
+  size_t count = 1;
+
+  bool converged = false;
+  for (size_t iter = 0; iter < GJK_MAX_ITERATIONS; iter++) {
+    count = gjk_solve(simplex, count);
+    if (count == 3) {
+      converged = true; // the origin is inside, the cores overlap
+      break;
+    }
+
+    // search towards the origin from the closest feature
+    vector_t direction;
+    if (count == 1) {
+      direction = vec_negate(simplex[0].w);
+    } else {
+      vector_t edge = vec_subtract(simplex[1].w, simplex[0].w);
+      if (vec_cross(edge, vec_negate(simplex[0].w)) > 0) {
+        direction = (vector_t){-edge.y, edge.x};
+      } else {
+        direction = (vector_t){edge.y, -edge.x};
+      }
+    }
+    if (vec_dot(direction, direction) == 0) {
+      converged = true; // the origin is on the simplex, the cores are touching
+      break;
+    }
+
+    gjk_vertex_t next = gjk_support(shape1, shape2, direction, &hint1, &hint2);
+    bool duplicate = false;
+    for (size_t i = 0; i < count; i++) {
+      if (simplex[i].index1 == next.index1 &&
+          simplex[i].index2 == next.index2) {
+        duplicate = true;
+      }
+    }
+    if (duplicate) {
+      converged = true; // no progress, so the current feature is the closest
+      break;
+    }
+    simplex[count++] = next;
+  }
+  if (!converged) {
+    // out of iterations: the last support point was never solved into the
+    // simplex, so its weights do not describe the closest point
+    return find_shape_collision(shape1, shape2);
+  }
+
+  if (count == 3) {
+    collision_info_t returned = epa(shape1, shape2, simplex, &hint1, &hint2);
+    if (returned.collided) {
+      returned.da_overlap += radii;
+      return returned;
+    }
+  } else {
+    vector_t closest = VEC_ZERO;
+    for (size_t i = 0; i < count; i++) {
+      closest = vec_add(closest, vec_multiply(simplex[i].weight, simplex[i].w));
+    }
+    double dist = vec_length(closest);
+    if (dist > 0) {
+      // the closest point of shape2 - shape1 points from shape1 to shape2
+      vector_t axis = vec_multiply(1 / dist, closest);
+      return (collision_info_t){dist < radii, axis, radii - dist};
+    }
+  }
+  // the cores are just touching or the polytope is degenerate
+  return find_shape_collision(shape1, shape2);
+}
+
+/**
+ * Reduces a simplex to the smallest sub-simplex containing the point closest
+ * to the origin and sets the barycentric weights of its vertices.
+ * See Ericson, Real-Time Collision Detection, section 9.5.
+ *
+ * @param simplex the vertices of the simplex, updated in place
+ * @param count the number of vertices (1 to 3)
+ * @return the number of vertices left in the simplex
+ */
+size_t gjk_solve(gjk_vertex_t *simplex, size_t count) {
+  vector_t w1 = simplex[0].w;
+  if (count == 1) {
+    simplex[0].weight = 1;
+    return 1;
+  }
+  vector_t w2 = simplex[1].w;
+  vector_t e12 = vec_subtract(w2, w1);
+  double d12_1 = vec_dot(w2, e12);
+  double d12_2 = -vec_dot(w1, e12);
+  if (count == 2) {
+    if (d12_2 <= 0) {
+      simplex[0].weight = 1;
+      return 1;
+    }
+    if (d12_1 <= 0) {
+      simplex[0] = simplex[1];
+      simplex[0].weight = 1;
+      return 1;
+    }
+    simplex[0].weight = d12_1 / (d12_1 + d12_2);
+    simplex[1].weight = d12_2 / (d12_1 + d12_2);
+    return 2;
+  }
+
+  vector_t w3 = simplex[2].w;
+  vector_t e13 = vec_subtract(w3, w1);
+  double d13_1 = vec_dot(w3, e13);
+  double d13_2 = -vec_dot(w1, e13);
+  vector_t e23 = vec_subtract(w3, w2);
+  double d23_1 = vec_dot(w3, e23);
+  double d23_2 = -vec_dot(w2, e23);
+  double n123 = vec_cross(e12, e13);
+  double d123_1 = n123 * vec_cross(w2, w3);
+  double d123_2 = n123 * vec_cross(w3, w1);
+  double d123_3 = n123 * vec_cross(w1, w2);
+
+  if (d12_2 <= 0 && d13_2 <= 0) { // vertex 1
+    simplex[0].weight = 1;
+    return 1;
+  }
+  if (d12_1 > 0 && d12_2 > 0 && d123_3 <= 0) { // edge 12
+    simplex[0].weight = d12_1 / (d12_1 + d12_2);
+    simplex[1].weight = d12_2 / (d12_1 + d12_2);
+    return 2;
+  }
+  if (d13_1 > 0 && d13_2 > 0 && d123_2 <= 0) { // edge 13
+    simplex[1] = simplex[2];
+    simplex[0].weight = d13_1 / (d13_1 + d13_2);
+    simplex[1].weight = d13_2 / (d13_1 + d13_2);
+    return 2;
+  }
+  if (d12_1 <= 0 && d23_2 <= 0) { // vertex 2
+    simplex[0] = simplex[1];
+    simplex[0].weight = 1;
+    return 1;
+  }
+  if (d13_1 <= 0 && d23_1 <= 0) { // vertex 3
+    simplex[0] = simplex[2];
+    simplex[0].weight = 1;
+    return 1;
+  }
+  if (d23_1 > 0 && d23_2 > 0 && d123_1 <= 0) { // edge 23
+    simplex[0] = simplex[2];
+    simplex[0].weight = d23_2 / (d23_1 + d23_2);
+    simplex[1].weight = d23_1 / (d23_1 + d23_2);
+    return 2;
+  }
+  double sum = d123_1 + d123_2 + d123_3; // inside the triangle
+  simplex[0].weight = d123_1 / sum;
+  simplex[1].weight = d123_2 / sum;
+  simplex[2].weight = d123_3 / sum;
+  return 3;
+}
+
+/**
+ * Expands the triangle GJK ended with towards the boundary of
+ * shape2 - shape1 until it finds the edge closest to the origin, which gives
+ * the penetration depth and axis of the cores.
+ */
+collision_info_t epa(const collision_shape_t *shape1,
+                     const collision_shape_t *shape2, gjk_vertex_t *simplex,
+                     size_t *hint1, size_t *hint2) {
+  vector_t polytope[EPA_MAX_VERTICES];
+  size_t count = 3;
+  polytope[0] = simplex[0].w;
+  if (vec_cross(vec_subtract(simplex[1].w, simplex[0].w),
+                vec_subtract(simplex[2].w, simplex[0].w)) > 0) {
+    polytope[1] = simplex[1].w;
+    polytope[2] = simplex[2].w;
+  } else { // keep the polytope counterclockwise
+    polytope[1] = simplex[2].w;
+    polytope[2] = simplex[1].w;
+  }
+
+  while (true) {
+    size_t closest = 0;
+    double closest_dist = INFINITY;
+    vector_t closest_normal = VEC_ZERO;
+    for (size_t i = 0; i < count; i++) {
+      vector_t edge = vec_subtract(polytope[(i + 1) % count], polytope[i]);
+      double length = vec_length(edge);
+      if (length == 0) {
+        continue;
+      }
+      vector_t normal = vec_multiply(1 / length, (vector_t){edge.y, -edge.x});
+      double dist = vec_dot(normal, polytope[i]);
+      if (dist < closest_dist) {
+        closest = i;
+        closest_dist = dist;
+        closest_normal = normal;
+      }
+    }
+    if (closest_dist == INFINITY) {
+      return (collision_info_t){false, VEC_ZERO, 0};
+    }
+
+    vector_t w = gjk_support(shape1, shape2, closest_normal, hint1, hint2).w;
+    double dist = vec_dot(w, closest_normal);
+    if (dist - closest_dist <= EPA_TOLERANCE * (1 + fabs(dist)) ||
+        count == EPA_MAX_VERTICES) {
+      // shape2 has to move back along the normal to leave shape1
+      return (collision_info_t){true, vec_negate(closest_normal),
+                                closest_dist};
+    }
+    for (size_t i = count; i > closest + 1; i--) {
+      polytope[i] = polytope[i - 1];
+    }
+    polytope[closest + 1] = w;
+    count++;
+  }
+}
+
+/**
+ * Finds the vertex of shape2 - shape1 farthest in a direction.
+ * The hints remember where the last support points of each shape were,
+ * so hill climbing starts next to the answer.
+ */
+gjk_vertex_t gjk_support(const collision_shape_t *shape1,
+                         const collision_shape_t *shape2, vector_t direction,
+                         size_t *hint1, size_t *hint2) {
+  *hint1 = support_index(shape1, vec_negate(direction), *hint1);
+  *hint2 = support_index(shape2, direction, *hint2);
+  vector_t point1 = vec_add(shape1->centroid, shape1->vertices[*hint1]);
+  vector_t point2 = vec_add(shape2->centroid, shape2->vertices[*hint2]);
+  return (gjk_vertex_t){vec_subtract(point2, point1), *hint1, *hint2, 0};
+}
+
+/**
+ * Checks box pairs one at a time, from index start to the end of the batch.
+ * The separating axis tests for two axis-aligned boxes reduce to comparing
+ * the distance between their centers with the sum of their half extents.
+ * As in SAT, x is reported when it separates the boxes or ties for the
+ * smallest overlap.
+ */
+void box_batch_scalar(box_batch_t *batch, size_t start) {
+  for (size_t i = start; i < batch->count; i++) {
+    double dx = batch->x2[i] - batch->x1[i];
+    double dy = batch->y2[i] - batch->y1[i];
+    double overlap_x =
+        batch->half_width1[i] + batch->half_width2[i] - fabs(dx);
+    double overlap_y =
+        batch->half_height1[i] + batch->half_height2[i] - fabs(dy);
+    batch->collided[i] = overlap_x > 0 && overlap_y > 0;
+    if (overlap_x > 0 && overlap_y < overlap_x) {
+      batch->axis_x[i] = 0;
+      batch->axis_y[i] = dy < 0 ? -1 : 1;
+      batch->overlap[i] = overlap_y;
+    } else {
+      batch->axis_x[i] = dx < 0 ? -1 : 1;
+      batch->axis_y[i] = 0;
+      batch->overlap[i] = overlap_x;
+    }
+  }
+}
+
+#ifdef __SSE2__
+/**
+ * Checks 2 box pairs per iteration, with the same logic as box_batch_scalar.
+ */
+void box_batch_sse2(box_batch_t *batch) {
+  __m128d sign = _mm_set1_pd(-0.0);
+  __m128d zero = _mm_setzero_pd();
+  __m128d one = _mm_set1_pd(1);
+  size_t i = 0;
+  for (; i + 2 <= batch->count; i += 2) {
+    __m128d dx = _mm_sub_pd(_mm_loadu_pd(batch->x2 + i),
+                            _mm_loadu_pd(batch->x1 + i));
+    __m128d dy = _mm_sub_pd(_mm_loadu_pd(batch->y2 + i),
+                            _mm_loadu_pd(batch->y1 + i));
+    __m128d overlap_x = _mm_sub_pd(
+        _mm_add_pd(_mm_loadu_pd(batch->half_width1 + i),
+                   _mm_loadu_pd(batch->half_width2 + i)),
+        _mm_andnot_pd(sign, dx));
+    __m128d overlap_y = _mm_sub_pd(
+        _mm_add_pd(_mm_loadu_pd(batch->half_height1 + i),
+                   _mm_loadu_pd(batch->half_height2 + i)),
+        _mm_andnot_pd(sign, dy));
+    __m128d x_positive = _mm_cmpgt_pd(overlap_x, zero);
+    __m128d collided = _mm_and_pd(x_positive, _mm_cmpgt_pd(overlap_y, zero));
+    __m128d use_y = _mm_and_pd(x_positive, _mm_cmplt_pd(overlap_y, overlap_x));
+    // +1 or -1 with the sign of the center offset (+1 when it is zero)
+    __m128d sign_x = _mm_or_pd(one, _mm_and_pd(_mm_cmplt_pd(dx, zero), sign));
+    __m128d sign_y = _mm_or_pd(one, _mm_and_pd(_mm_cmplt_pd(dy, zero), sign));
+
+    _mm_storeu_pd(batch->axis_x + i, _mm_andnot_pd(use_y, sign_x));
+    _mm_storeu_pd(batch->axis_y + i, _mm_and_pd(use_y, sign_y));
+    _mm_storeu_pd(batch->overlap + i,
+                  _mm_or_pd(_mm_and_pd(use_y, overlap_y),
+                            _mm_andnot_pd(use_y, overlap_x)));
+    int mask = _mm_movemask_pd(collided);
+    batch->collided[i] = mask & 1;
+    batch->collided[i + 1] = (mask >> 1) & 1;
+  }
+  box_batch_scalar(batch, i);
+}
+#endif
+
+#ifdef HAVE_AVX2_DISPATCH
+/**
+ * Checks 4 box pairs per iteration, with the same logic as box_batch_scalar.
+ */
+__attribute__((target("avx2"))) void box_batch_avx2(box_batch_t *batch) {
+  __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d zero = _mm256_setzero_pd();
+  __m256d one = _mm256_set1_pd(1);
+  size_t i = 0;
+  for (; i + 4 <= batch->count; i += 4) {
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(batch->x2 + i),
+                               _mm256_loadu_pd(batch->x1 + i));
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(batch->y2 + i),
+                               _mm256_loadu_pd(batch->y1 + i));
+    __m256d overlap_x = _mm256_sub_pd(
+        _mm256_add_pd(_mm256_loadu_pd(batch->half_width1 + i),
+                      _mm256_loadu_pd(batch->half_width2 + i)),
+        _mm256_andnot_pd(sign, dx));
+    __m256d overlap_y = _mm256_sub_pd(
+        _mm256_add_pd(_mm256_loadu_pd(batch->half_height1 + i),
+                      _mm256_loadu_pd(batch->half_height2 + i)),
+        _mm256_andnot_pd(sign, dy));
+    __m256d x_positive = _mm256_cmp_pd(overlap_x, zero, _CMP_GT_OQ);
+    __m256d collided = _mm256_and_pd(
+        x_positive, _mm256_cmp_pd(overlap_y, zero, _CMP_GT_OQ));
+    __m256d use_y = _mm256_and_pd(
+        x_positive, _mm256_cmp_pd(overlap_y, overlap_x, _CMP_LT_OQ));
+    __m256d sign_x = _mm256_or_pd(
+        one, _mm256_and_pd(_mm256_cmp_pd(dx, zero, _CMP_LT_OQ), sign));
+    __m256d sign_y = _mm256_or_pd(
+        one, _mm256_and_pd(_mm256_cmp_pd(dy, zero, _CMP_LT_OQ), sign));
+
+    _mm256_storeu_pd(batch->axis_x + i, _mm256_andnot_pd(use_y, sign_x));
+    _mm256_storeu_pd(batch->axis_y + i, _mm256_and_pd(use_y, sign_y));
+    _mm256_storeu_pd(batch->overlap + i,
+                     _mm256_blendv_pd(overlap_x, overlap_y, use_y));
+    int mask = _mm256_movemask_pd(collided);
+    for (size_t j = 0; j < 4; j++) {
+      batch->collided[i + j] = (mask >> j) & 1;
+    }
+  }
+  box_batch_scalar(batch, i);
+}
+#endif
+
+void find_box_collisions(box_batch_t *batch) {
+#ifdef HAVE_AVX2_DISPATCH
+  if (__builtin_cpu_supports("avx2")) {
+    box_batch_avx2(batch);
+    return;
+  }
+#endif
+#ifdef __SSE2__
+  box_batch_sse2(batch);
+#else
+  box_batch_scalar(batch, 0);
+#endif
+}
+
+bool collision_shape_is_box(const collision_shape_t *shape,
+                            vector_t *half_extents) {
+  if (shape->kind != SHAPE_POLYGON || shape->size != 4) {
+    return false;
+  }
+  vector_t max = {-INFINITY, -INFINITY};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t normal = shape->normals[i];
+    if (normal.x != 0 && normal.y != 0) {
+      return false;
+    }
+    max.x = fmax(max.x, shape->vertices[i].x);
+    max.y = fmax(max.y, shape->vertices[i].y);
+  }
+  // an axis-aligned rectangle has each corner at (+-w, +-h) from its center
+  for (size_t i = 0; i < 4; i++) {
+    if (fabs(shape->vertices[i].x) != max.x ||
+        fabs(shape->vertices[i].y) != max.y) {
+      return false;
+    }
+  }
+  *half_extents = max;
+  return true;
+}
+
+/**
+ * Checks whether a shape is a polygon whose edges are all horizontal or
+ * vertical, i.e. exactly fills its bounding box.
+ */
+bool shape_fills_aabb(const collision_shape_t *shape) {
+  if (shape->kind != SHAPE_POLYGON) {
+    return false;
+  }
+  for (size_t i = 0; i < shape->size; i++) {
+    if (shape->normals[i].x != 0 && shape->normals[i].y != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool find_shape_overlap(const collision_shape_t *shape1,
+                        const collision_shape_t *shape2) {
+  if (!aabb_overlap(collision_shape_aabb(shape1),
+                    collision_shape_aabb(shape2))) {
+    return false;
+  }
+  if (shape_fills_aabb(shape1) && shape_fills_aabb(shape2)) {
+    return true;
+  }
+  return find_shape_collision(shape1, shape2).collided;
+}
+
+/**
+ * Gets the normal of an edge of a shape that points away from the shape,
+ * whichever way round its vertices go.
+ */
+vector_t outward_normal(const collision_shape_t *shape, size_t edge) {
+  vector_t normal = shape->normals[edge];
+  if (vec_dot(normal, shape->vertices[edge]) < 0) {
+    return vec_negate(normal);
+  }
+  return normal;
+}
+
+/**
+ * Finds the edge of a polygon whose outward normal is closest to a direction.
+ */
+size_t reference_face(const collision_shape_t *shape, vector_t direction) {
+  size_t best = 0;
+  double best_dot = -INFINITY;
+  for (size_t i = 0; i < shape->size; i++) {
+    double dot = vec_dot(outward_normal(shape, i), direction);
+    if (dot > best_dot) {
+      best = i;
+      best_dot = dot;
+    }
+  }
+  return best;
+}
+
+/**
+ * Cuts off the part of a segment where dot(normal, point) > offset.
+ * A point created by the cut takes the feature id clip_feature.
+ *
+ * @return the number of points left (0 or 2)
+ */
+size_t clip_segment(vector_t *points, uint32_t *features, vector_t normal,
+                    double offset, uint32_t clip_feature) {
+  double distance0 = vec_dot(normal, points[0]) - offset;
+  double distance1 = vec_dot(normal, points[1]) - offset;
+  if (distance0 > 0 && distance1 > 0) {
+    return 0;
+  }
+  if (distance0 * distance1 < 0) {
+    size_t outside = distance0 > 0 ? 0 : 1;
+    double fraction = distance0 / (distance0 - distance1);
+    vector_t along = vec_subtract(points[1], points[0]);
+    points[outside] = vec_add(points[0], vec_multiply(fraction, along));
+    features[outside] = clip_feature;
+  }
+  return 2;
+}
+
+/**
+ * Finds the contact points of two colliding polygons by clipping the
+ * incident edge against the reference edge. Reports no points if clipping
+ * leaves none.
+ */
+contact_manifold_t clip_manifold(const collision_shape_t *shape1,
+                                 const collision_shape_t *shape2,
+                                 collision_info_t info) {
+  contact_manifold_t manifold = {0, info.axis, {VEC_ZERO, VEC_ZERO}, {0, 0},
+                                 {0, 0}};
+
+  // the reference edge is whichever edge faces the other shape most directly
+  size_t edge1 = reference_face(shape1, info.axis);
+  size_t edge2 = reference_face(shape2, vec_negate(info.axis));
+  double facing1 = vec_dot(outward_normal(shape1, edge1), info.axis);
+  double facing2 = vec_dot(outward_normal(shape2, edge2), vec_negate(info.axis));
+  bool flip = facing2 > facing1 + MANIFOLD_FACE_TOLERANCE;
+  const collision_shape_t *reference = flip ? shape2 : shape1;
+  const collision_shape_t *incident = flip ? shape1 : shape2;
+  size_t edge = flip ? edge2 : edge1;
+  vector_t normal = outward_normal(reference, edge);
+
+  // the incident edge is the edge of the other shape facing back the most
+  size_t incident_edge = reference_face(incident, vec_negate(normal));
+  size_t next = (incident_edge + 1) % incident->size;
+  vector_t points[2] = {
+      vec_add(incident->centroid, incident->vertices[incident_edge]),
+      vec_add(incident->centroid, incident->vertices[next])};
+  uint32_t base = (flip ? 1u << 31 : 0) | (uint32_t)edge << 16;
+  uint32_t features[2] = {base | (uint32_t)incident_edge, base | (uint32_t)next};
+
+  // clip the incident edge to the sides of the reference edge
+  vector_t start =
+      vec_add(reference->centroid, reference->vertices[edge]);
+  vector_t end = vec_add(reference->centroid,
+                         reference->vertices[(edge + 1) % reference->size]);
+  vector_t tangent = vec_normalize(vec_subtract(end, start));
+  if (clip_segment(points, features, vec_negate(tangent),
+                   -vec_dot(tangent, start), base | 0x8000) == 0 ||
+      clip_segment(points, features, tangent, vec_dot(tangent, end),
+                   base | 0x8001) == 0) {
+    return manifold;
+  }
+
+  // keep the points that are behind the reference edge
+  manifold.normal = flip ? vec_negate(normal) : normal;
+  for (size_t i = 0; i < 2; i++) {
+    double separation = vec_dot(normal, vec_subtract(points[i], start));
+    if (separation <= 0) {
+      manifold.points[manifold.count] = points[i];
+      manifold.depths[manifold.count] = -separation;
+      manifold.features[manifold.count] = features[i];
+      manifold.count++;
+    }
+  }
+  return manifold;
+}
+
+contact_manifold_t find_contact_manifold(const collision_shape_t *shape1,
+                                         const collision_shape_t *shape2,
+                                         collision_info_t info) {
+  contact_manifold_t manifold = {0, info.axis, {VEC_ZERO, VEC_ZERO}, {0, 0},
+                                 {0, 0}};
+  if (!info.collided) {
+    return manifold;
+  }
+  if (shape1->kind == SHAPE_POLYGON && shape2->kind == SHAPE_POLYGON &&
+      shape1->size >= 2 && shape2->size >= 2) {
+    manifold = clip_manifold(shape1, shape2, info);
+    if (manifold.count > 0) {
+      return manifold;
+    }
+  }
+  // halfway between the deepest points of the two shapes
+  vector_t deepest1 = collision_shape_support(shape1, info.axis);
+  vector_t deepest2 = collision_shape_support(shape2, vec_negate(info.axis));
+  manifold.count = 1;
+  manifold.normal = info.axis;
+  manifold.points[0] = vec_multiply(0.5, vec_add(deepest1, deepest2));
+  manifold.depths[0] = info.da_overlap;
+  manifold.features[0] = 0;
+  return manifold;
+}
+
+time_of_impact_t find_time_of_impact(const collision_shape_t *shape1,
+                                     vector_t displacement1,
+                                     const collision_shape_t *shape2,
+                                     vector_t displacement2) {
+  time_of_impact_t miss = {false, 1, VEC_ZERO, true};
+  aabb_t swept1 = aabb_expand(collision_shape_aabb(shape1), 0, displacement1);
+  aabb_t swept2 = aabb_expand(collision_shape_aabb(shape2), 0, displacement2);
+  if (!aabb_overlap(swept1, swept2)) {
+    return miss;
+  }
+
+  // move shape1 relative to shape2, which stays put
+  vector_t motion = vec_subtract(displacement1, displacement2);
+  collision_shape_t moved = *shape1;
+  double time = 0;
+  // the axis the gap was last closed along; once the shapes touch, GJK's
+  // own axis can point anywhere along the touching edges
+  vector_t separating = VEC_ZERO;
+  for (size_t iter = 0; iter < TOI_MAX_ITERATIONS; iter++) {
+    moved.centroid = vec_add(shape1->centroid, vec_multiply(time, motion));
+    collision_info_t info = find_shape_collision_gjk(&moved, shape2);
+    double distance = -info.da_overlap;
+    if (info.collided || distance <= TOI_TOLERANCE) {
+      vector_t axis = iter == 0 ? info.axis : separating;
+      return (time_of_impact_t){true, time, axis, true};
+    }
+    separating = info.axis;
+    // the shapes cannot touch before they close the gap along the axis,
+    // and never will if they are not approaching along it
+    double closing = vec_dot(motion, info.axis);
+    if (closing <= 0) {
+      return miss;
+    }
+    time += distance / closing;
+    if (time > 1) {
+      return miss;
+    }
+  }
+  // out of steps while still closing in (e.g. a grazing approach): the
+  // shapes do not overlap yet at the last step, so it only counts as a hit
+  // if they are nearly touching there
+  moved.centroid = vec_add(shape1->centroid, vec_multiply(time, motion));
+  collision_info_t info = find_shape_collision_gjk(&moved, shape2);
+  bool touching =
+      info.collided || -info.da_overlap <= TOI_UNCONVERGED_TOLERANCE;
+  return (time_of_impact_t){touching, time, separating, false};
+}
+
+time_of_impact_t find_ray_intersection(const collision_shape_t *shape,
+                                       vector_t origin, vector_t translation) {
+  // a circle of radius 0 at the origin of the ray
+  vector_t center = VEC_ZERO;
+  vector_t normal = VEC_ZERO;
+  collision_shape_t point = {1, &center, &normal, origin, SHAPE_CIRCLE, 0};
+  time_of_impact_t impact =
+      find_time_of_impact(&point, translation, shape, VEC_ZERO);
+  impact.axis = vec_negate(impact.axis);
+  return impact;
+}
+
+void find_shape_collisions(narrow_phase_t narrow_phase, size_t count,
+                           const collision_shape_t *shapes1,
+                           const collision_shape_t *shapes2,
+                           separating_axis_cache_t **caches,
+                           collision_info_t *results) {
+  size_t *indices = malloc(count * sizeof(size_t));
+  assert(indices);
+  bool *collided = malloc(count * sizeof(bool));
+  assert(collided);
+  double *columns = malloc(11 * count * sizeof(double));
+  assert(columns);
+  double *x1 = columns;
+  double *y1 = columns + count;
+  double *half_width1 = columns + 2 * count;
+  double *half_height1 = columns + 3 * count;
+  double *x2 = columns + 4 * count;
+  double *y2 = columns + 5 * count;
+  double *half_width2 = columns + 6 * count;
+  double *half_height2 = columns + 7 * count;
+
+  box_batch_t batch;
+  batch.count = 0;
+  batch.x1 = x1;
+  batch.y1 = y1;
+  batch.half_width1 = half_width1;
+  batch.half_height1 = half_height1;
+  batch.x2 = x2;
+  batch.y2 = y2;
+  batch.half_width2 = half_width2;
+  batch.half_height2 = half_height2;
+  batch.collided = collided;
+  batch.axis_x = columns + 8 * count;
+  batch.axis_y = columns + 9 * count;
+  batch.overlap = columns + 10 * count;
+
+  for (size_t i = 0; i < count; i++) {
+    vector_t half1;
+    vector_t half2;
+    if (collision_shape_is_box(&shapes1[i], &half1) &&
+        collision_shape_is_box(&shapes2[i], &half2)) {
+      size_t j = batch.count++;
+      indices[j] = i;
+      x1[j] = shapes1[i].centroid.x;
+      y1[j] = shapes1[i].centroid.y;
+      half_width1[j] = half1.x;
+      half_height1[j] = half1.y;
+      x2[j] = shapes2[i].centroid.x;
+      y2[j] = shapes2[i].centroid.y;
+      half_width2[j] = half2.x;
+      half_height2[j] = half2.y;
+    } else {
+      separating_axis_cache_t *cache = caches == NULL ? NULL : caches[i];
+      results[i] = find_shape_collision_with(narrow_phase, &shapes1[i],
+                                             &shapes2[i], cache);
+    }
+  }
+
+  find_box_collisions(&batch);
+  for (size_t j = 0; j < batch.count; j++) {
+    results[indices[j]] = (collision_info_t){
+        batch.collided[j], (vector_t){batch.axis_x[j], batch.axis_y[j]},
+        batch.overlap[j]};
+  }
+
+  free(indices);
+  free(columns);
+  free(collided);
+}
+
+/**
+ * Finds the index of the vertex of a shape's core farthest in a direction.
+ * Large polygons hill climb from start instead of checking every vertex,
+ * since the projections of a convex polygon's vertices rise and fall only
+ * once around the polygon.
+ */
+size_t support_index(const collision_shape_t *shape, vector_t direction,
+                     size_t start) {
+  size_t size = shape->size;
+  const vector_t *vertices = shape->vertices;
+  size_t best = start < size ? start : 0;
+  double best_dot = vec_dot(vertices[best], direction);
+
+  if (size > HILL_CLIMB_MIN_SIZE) {
+    while (true) {
+      size_t next = (best + 1) % size;
+      size_t prev = (best + size - 1) % size;
+      double next_dot = vec_dot(vertices[next], direction);
+      double prev_dot = vec_dot(vertices[prev], direction);
+      if (next_dot > best_dot) {
+        best = next;
+        best_dot = next_dot;
+      } else if (prev_dot > best_dot) {
+        best = prev;
+        best_dot = prev_dot;
+      } else if (next_dot < best_dot && prev_dot < best_dot) {
+        return best;
+      } else {
+        break; // on a flat stretch, which could be the minimum
+      }
+    }
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    double dot = vec_dot(vertices[i], direction);
+    if (dot > best_dot) {
+      best = i;
+      best_dot = dot;
+    }
+  }
+  return best;
+}
+
+vector_t collision_shape_support(const collision_shape_t *shape,
+                                 vector_t direction) {
+  size_t index = support_index(shape, direction, 0);
+  vector_t point = vec_add(shape->centroid, shape->vertices[index]);
+  if (shape->radius > 0) {
+    vector_t offset = vec_multiply(shape->radius, vec_normalize(direction));
+    point = vec_add(point, offset);
+  }
+  return point;
+}
+
+aabb_t collision_shape_aabb(const collision_shape_t *shape) {
+  aabb_t box = {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}};
+  for (size_t i = 0; i < shape->size; i++) {
+    box.min.x = fmin(box.min.x, shape->vertices[i].x);
+    box.min.y = fmin(box.min.y, shape->vertices[i].y);
+    box.max.x = fmax(box.max.x, shape->vertices[i].x);
+    box.max.y = fmax(box.max.y, shape->vertices[i].y);
+  }
+  vector_t radius = {shape->radius, shape->radius};
+  box.min = vec_subtract(vec_add(box.min, shape->centroid), radius);
+  box.max = vec_add(vec_add(box.max, shape->centroid), radius);
+  return box;
+}
+
+bool aabb_overlap(aabb_t aabb1, aabb_t aabb2) {
+  return aabb1.min.x < aabb2.max.x && aabb2.min.x < aabb1.max.x &&
+         aabb1.min.y < aabb2.max.y && aabb2.min.y < aabb1.max.y;
+}
+
+/**
+ * Narrows the range of fractions [enter, leave] of a segment to those where
+ * one coordinate is within [min, max].
+ * @return false if the range becomes empty
+ */
+bool aabb_clip_slab(double min, double max, double start, double delta,
+                    double *enter, double *leave) {
+  if (delta == 0) {
+    return min < start && start < max;
+  }
+  double t1 = (min - start) / delta;
+  double t2 = (max - start) / delta;
+  *enter = fmax(*enter, fmin(t1, t2));
+  *leave = fmin(*leave, fmax(t1, t2));
+  return *enter <= *leave;
+}
+
+bool aabb_ray_overlap(aabb_t aabb, vector_t origin, vector_t translation) {
+  double enter = 0;
+  double leave = 1;
+  return aabb_clip_slab(aabb.min.x, aabb.max.x, origin.x, translation.x,
+                        &enter, &leave) &&
+         aabb_clip_slab(aabb.min.y, aabb.max.y, origin.y, translation.y,
+                        &enter, &leave);
+}
+
+aabb_t aabb_union(aabb_t aabb1, aabb_t aabb2) {
+  vector_t min = {fmin(aabb1.min.x, aabb2.min.x),
+                  fmin(aabb1.min.y, aabb2.min.y)};
+  vector_t max = {fmax(aabb1.max.x, aabb2.max.x),
+                  fmax(aabb1.max.y, aabb2.max.y)};
+  return (aabb_t){min, max};
+}
+
+bool aabb_contains(aabb_t outer, aabb_t inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+aabb_t aabb_expand(aabb_t aabb, double margin, vector_t displacement) {
+  aabb_t grown = {vec_subtract(aabb.min, (vector_t){margin, margin}),
+                  vec_add(aabb.max, (vector_t){margin, margin})};
+  if (displacement.x < 0) {
+    grown.min.x += displacement.x;
+  } else {
+    grown.max.x += displacement.x;
+  }
+  if (displacement.y < 0) {
+    grown.min.y += displacement.y;
+  } else {
+    grown.max.y += displacement.y;
+  }
+  return grown;
+}
+
+double vec_length(vector_t vec) { return sqrt(vec.x * vec.x + vec.y * vec.y); }
 
 vector_t vec_normalize(vector_t vec) {
-  return (vector_t){vec.x / vec_length(vec), vec.y / vec_length(vec)};
+  double length = vec_length(vec);
+  return (vector_t){vec.x / length, vec.y / length};
 }
@@ -0,0 +1,142 @@
+#include "component_store.h"
+#include "body_table.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t COMPONENT_INITIAL_CAPACITY = 16;
+// the size of each type of component, indexed by component_type_t
+const size_t COMPONENT_SIZES[COMPONENT_TYPE_COUNT] = {
+    sizeof(timer_component_t), sizeof(emitter_component_t)};
+
+typedef struct {
+  // the body, with a NULL second body
+  body_key_t key;
+  // where the body's component is in the dense arrays
+  size_t index;
+} component_slot_t;
+
+typedef struct {
+  size_t size;
+  // the owner of each component, in the same order as components
+  body_t **bodies;
+  char *components;
+  size_t count;
+  size_t capacity;
+  // a component_slot_t for each body with a component
+  body_table_t *slots;
+} component_pool_t;
+
+struct component_store {
+  component_pool_t pools[COMPONENT_TYPE_COUNT];
+};
+
+component_store_t *component_store_init(void) {
+  component_store_t *store = malloc(sizeof(component_store_t));
+  assert(store);
+  for (size_t i = 0; i < COMPONENT_TYPE_COUNT; i++) {
+    component_pool_t *pool = &store->pools[i];
+    pool->size = COMPONENT_SIZES[i];
+    pool->capacity = COMPONENT_INITIAL_CAPACITY;
+    pool->bodies = malloc(pool->capacity * sizeof(body_t *));
+    assert(pool->bodies);
+    pool->components = malloc(pool->capacity * pool->size);
+    assert(pool->components);
+    pool->count = 0;
+    pool->slots = body_table_init(sizeof(component_slot_t),
+                                  2 * COMPONENT_INITIAL_CAPACITY);
+  }
+  return store;
+}
+
+void component_store_free(component_store_t *store) {
+  for (size_t i = 0; i < COMPONENT_TYPE_COUNT; i++) {
+    free(store->pools[i].bodies);
+    free(store->pools[i].components);
+    body_table_free(store->pools[i].slots);
+  }
+  free(store);
+}
+
+void *component_store_add(component_store_t *store, component_type_t type,
+                          body_t *body) {
+  assert(body != NULL);
+  component_pool_t *pool = &store->pools[type];
+  component_slot_t *slot = body_table_find(pool->slots, body, NULL);
+  if (slot != NULL) {
+    return pool->components + slot->index * pool->size;
+  }
+
+  if (pool->count == pool->capacity) {
+    pool->capacity *= 2;
+    pool->bodies = realloc(pool->bodies, pool->capacity * sizeof(body_t *));
+    assert(pool->bodies);
+    pool->components =
+        realloc(pool->components, pool->capacity * pool->size);
+    assert(pool->components);
+  }
+  slot = body_table_add(pool->slots, body, NULL);
+  slot->index = pool->count;
+  pool->bodies[pool->count] = body;
+  void *component = pool->components + pool->count * pool->size;
+  memset(component, 0, pool->size);
+  pool->count++;
+  return component;
+}
+
+void *component_store_get(component_store_t *store, component_type_t type,
+                          body_t *body) {
+  component_pool_t *pool = &store->pools[type];
+  component_slot_t *slot = body_table_find(pool->slots, body, NULL);
+  if (slot == NULL) {
+    return NULL;
+  }
+  return pool->components + slot->index * pool->size;
+}
+
+void component_store_remove(component_store_t *store, component_type_t type,
+                            body_t *body) {
+  component_pool_t *pool = &store->pools[type];
+  component_slot_t *slot = body_table_find(pool->slots, body, NULL);
+  if (slot == NULL) {
+    return;
+  }
+  size_t index = slot->index;
+  body_table_remove(pool->slots, slot);
+
+  // fill the gap in the dense arrays with the last component
+  size_t last = pool->count - 1;
+  if (index != last) {
+    body_t *moved = pool->bodies[last];
+    pool->bodies[index] = moved;
+    memcpy(pool->components + index * pool->size,
+           pool->components + last * pool->size, pool->size);
+    component_slot_t *moved_slot = body_table_find(pool->slots, moved, NULL);
+    moved_slot->index = index;
+  }
+  pool->count--;
+}
+
+void component_store_remove_body(component_store_t *store, body_t *body) {
+  for (size_t i = 0; i < COMPONENT_TYPE_COUNT; i++) {
+    component_store_remove(store, i, body);
+  }
+}
+
+size_t component_store_count(component_store_t *store, component_type_t type) {
+  return store->pools[type].count;
+}
+
+void *component_store_get_at(component_store_t *store, component_type_t type,
+                             size_t index) {
+  component_pool_t *pool = &store->pools[type];
+  assert(index < pool->count);
+  return pool->components + index * pool->size;
+}
+
+body_t *component_store_get_body(component_store_t *store,
+                                 component_type_t type, size_t index) {
+  component_pool_t *pool = &store->pools[type];
+  assert(index < pool->count);
+  return pool->bodies[index];
+}
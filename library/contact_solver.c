@@ -0,0 +1,155 @@
+#include "contact_solver.h"
+#include <math.h>
+
+const size_t CONTACT_SOLVER_ITERATIONS = 8;
+// how deep bodies may overlap before they are moved apart, which keeps
+// resting contacts touching from one tick to the next
+const double CONTACT_SLOP = 0.05;
+// the fraction of the remaining overlap removed each tick
+const double CONTACT_CORRECTION = 0.4;
+// slower approaches than this do not bounce, so resting bodies settle
+const double CONTACT_BOUNCE_THRESHOLD = 10;
+
+void contact_solver_update_manifold(pair_entry_t *pair,
+                                    contact_manifold_t manifold) {
+  double normal_impulses[2] = {0, 0};
+  double tangent_impulses[2] = {0, 0};
+  for (size_t i = 0; i < manifold.count; i++) {
+    for (size_t j = 0; j < pair->manifold.count; j++) {
+      if (manifold.features[i] == pair->manifold.features[j]) {
+        normal_impulses[i] = pair->normal_impulses[j];
+        tangent_impulses[i] = pair->tangent_impulses[j];
+      }
+    }
+  }
+  pair->manifold = manifold;
+  for (size_t i = 0; i < 2; i++) {
+    pair->normal_impulses[i] = normal_impulses[i];
+    pair->tangent_impulses[i] = tangent_impulses[i];
+  }
+}
+
+/**
+ * Applies equal and opposite impulses to a pair, pushing body2 along impulse.
+ */
+void contact_apply_impulse(pair_entry_t *pair, vector_t impulse) {
+  body_add_impulse(pair->body1, vec_negate(impulse));
+  body_add_impulse(pair->body2, impulse);
+}
+
+/**
+ * Gets the velocity of body2 relative to body1 at the end of the tick,
+ * including the impulses applied so far.
+ */
+vector_t contact_relative_velocity(pair_entry_t *pair, double dt) {
+  return vec_subtract(body_get_next_velocity(pair->body2, dt),
+                      body_get_next_velocity(pair->body1, dt));
+}
+
+/**
+ * Gets the sum of the inverse masses of a pair; 0 if neither body can move.
+ */
+double contact_inverse_mass(pair_entry_t *pair) {
+  return 1 / body_get_mass(pair->body1) + 1 / body_get_mass(pair->body2);
+}
+
+/**
+ * Works out how fast a contact should bounce and reapplies last tick's
+ * impulses.
+ */
+void contact_prepare(contact_constraint_t *contact) {
+  pair_entry_t *pair = contact->pair;
+  vector_t normal = pair->manifold.normal;
+  vector_t tangent = {-normal.y, normal.x};
+  vector_t velocity = vec_subtract(body_get_velocity(pair->body2),
+                                   body_get_velocity(pair->body1));
+  double approach = vec_dot(velocity, normal);
+  contact->bounce =
+      approach < -CONTACT_BOUNCE_THRESHOLD ? -contact->elasticity * approach : 0;
+  for (size_t i = 0; i < pair->manifold.count; i++) {
+    vector_t impulse =
+        vec_add(vec_multiply(pair->normal_impulses[i], normal),
+                vec_multiply(pair->tangent_impulses[i], tangent));
+    contact_apply_impulse(pair, impulse);
+  }
+}
+
+/**
+ * Runs one pass over the points of a contact, first removing sliding within
+ * the friction limit, then stopping the bodies from approaching.
+ */
+void contact_iterate(contact_constraint_t *contact, double dt) {
+  pair_entry_t *pair = contact->pair;
+  vector_t normal = pair->manifold.normal;
+  vector_t tangent = {-normal.y, normal.x};
+  double mass = 1 / contact_inverse_mass(pair);
+  for (size_t i = 0; i < pair->manifold.count; i++) {
+    if (contact->friction > 0) {
+      double slide = vec_dot(contact_relative_velocity(pair, dt), tangent);
+      double limit = contact->friction * pair->normal_impulses[i];
+      double old = pair->tangent_impulses[i];
+      double accumulated = fmax(-limit, fmin(old - slide * mass, limit));
+      pair->tangent_impulses[i] = accumulated;
+      contact_apply_impulse(pair, vec_multiply(accumulated - old, tangent));
+    }
+
+    double approach = vec_dot(contact_relative_velocity(pair, dt), normal);
+    double old = pair->normal_impulses[i];
+    double accumulated = fmax(old + (contact->bounce - approach) * mass, 0);
+    pair->normal_impulses[i] = accumulated;
+    contact_apply_impulse(pair, vec_multiply(accumulated - old, normal));
+  }
+}
+
+/**
+ * Moves the bodies of a contact apart along its normal, in proportion to
+ * their inverse masses, to remove part of the overlap the velocities missed.
+ */
+void contact_correct_position(contact_constraint_t *contact) {
+  pair_entry_t *pair = contact->pair;
+  double depth = 0;
+  for (size_t i = 0; i < pair->manifold.count; i++) {
+    depth = fmax(depth, pair->manifold.depths[i]);
+  }
+  double correction = fmax(depth - CONTACT_SLOP, 0) * CONTACT_CORRECTION /
+                      contact_inverse_mass(pair);
+  if (correction == 0) {
+    return;
+  }
+  vector_t push = vec_multiply(correction, pair->manifold.normal);
+  body_t *body1 = pair->body1;
+  body_t *body2 = pair->body2;
+  double inverse_mass1 = 1 / body_get_mass(body1);
+  double inverse_mass2 = 1 / body_get_mass(body2);
+  if (inverse_mass1 > 0) {
+    body_set_centroid(body1, vec_subtract(body_get_centroid(body1),
+                                          vec_multiply(inverse_mass1, push)));
+  }
+  if (inverse_mass2 > 0) {
+    body_set_centroid(body2, vec_add(body_get_centroid(body2),
+                                     vec_multiply(inverse_mass2, push)));
+  }
+}
+
+void contact_solver_solve(contact_constraint_t *contacts, size_t count,
+                          double dt, size_t iterations) {
+  // pairs of immovable bodies are left alone
+  size_t solvable = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (contact_inverse_mass(contacts[i].pair) > 0) {
+      contacts[solvable++] = contacts[i];
+    }
+  }
+
+  for (size_t i = 0; i < solvable; i++) {
+    contact_prepare(&contacts[i]);
+  }
+  for (size_t iteration = 0; iteration < iterations; iteration++) {
+    for (size_t i = 0; i < solvable; i++) {
+      contact_iterate(&contacts[i], dt);
+    }
+  }
+  for (size_t i = 0; i < solvable; i++) {
+    contact_correct_position(&contacts[i]);
+  }
+}
@@ -0,0 +1,53 @@
+#include "force_field.h"
+#include <math.h>
+
+force_field_t force_field_gravity(vector_t acceleration, uint32_t categories) {
+  return (force_field_t){FORCE_FIELD_GRAVITY, acceleration, 0,
+                         (aabb_t){VEC_ZERO, VEC_ZERO}, categories};
+}
+
+force_field_t force_field_drag(double gamma, uint32_t categories) {
+  return (force_field_t){FORCE_FIELD_DRAG, VEC_ZERO, gamma,
+                         (aabb_t){VEC_ZERO, VEC_ZERO}, categories};
+}
+
+force_field_t force_field_wind(aabb_t zone, vector_t velocity, double gamma,
+                               uint32_t categories) {
+  return (force_field_t){FORCE_FIELD_WIND, velocity, gamma, zone, categories};
+}
+
+vector_t force_fields_get_force(const force_field_t *fields, size_t count,
+                                body_t *body) {
+  double mass = body_get_mass(body);
+  double scale = body_get_field_scale(body);
+  if (mass == INFINITY || scale == 0) {
+    return VEC_ZERO;
+  }
+  uint32_t category = body_get_collision_category(body);
+  vector_t velocity = body_get_velocity(body);
+  vector_t centroid = body_get_centroid(body);
+
+  vector_t force = VEC_ZERO;
+  for (size_t i = 0; i < count; i++) {
+    const force_field_t *field = &fields[i];
+    if ((field->categories & category) == 0) {
+      continue;
+    }
+    switch (field->kind) {
+    case FORCE_FIELD_GRAVITY:
+      force = vec_add(force, vec_multiply(mass, field->vector));
+      break;
+    case FORCE_FIELD_DRAG:
+      force = vec_add(force, vec_multiply(-field->gamma, velocity));
+      break;
+    case FORCE_FIELD_WIND:
+      if (centroid.x >= field->zone.min.x && centroid.x <= field->zone.max.x &&
+          centroid.y >= field->zone.min.y && centroid.y <= field->zone.max.y) {
+        vector_t relative = vec_subtract(field->vector, velocity);
+        force = vec_add(force, vec_multiply(field->gamma, relative));
+      }
+      break;
+    }
+  }
+  return vec_multiply(scale, force);
+}
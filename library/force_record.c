@@ -0,0 +1,88 @@
+#include "force_record.h"
+#include <math.h>
+
+// Newtonian gravity is not applied between bodies closer than this, since
+// its magnitude blows up as the distance goes to 0
+const double GRAVITY_DISTANCE = 5.0;
+
+/**
+ * Pulls each pair of bodies together with a force of k times their
+ * distance.
+ */
+void force_records_apply_springs(const force_record_t *records,
+                                 size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const force_record_t *record = &records[i];
+    vector_t offset = vec_subtract(body_get_centroid(record->body2),
+                                   body_get_centroid(record->body1));
+    vector_t force = vec_multiply(record->constant, offset);
+    body_add_force(record->body1, force);
+    body_add_force(record->body2, vec_negate(force));
+  }
+}
+
+/**
+ * Pulls each pair of bodies together with a force of G m1 m2 / r^2.
+ */
+void force_records_apply_newtonian_gravity(const force_record_t *records,
+                                           size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const force_record_t *record = &records[i];
+    vector_t offset = vec_subtract(body_get_centroid(record->body2),
+                                   body_get_centroid(record->body1));
+    double distance = sqrt(vec_dot(offset, offset));
+    if (distance < GRAVITY_DISTANCE) {
+      continue;
+    }
+    double magnitude = record->constant * body_get_mass(record->body1) *
+                       body_get_mass(record->body2) / (distance * distance);
+    vector_t force = vec_multiply(magnitude / distance, offset);
+    body_add_force(record->body1, force);
+    body_add_force(record->body2, vec_negate(force));
+  }
+}
+
+/**
+ * Slows each body with a force of -gamma times its velocity.
+ */
+void force_records_apply_drag(const force_record_t *records, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const force_record_t *record = &records[i];
+    body_add_force(record->body1,
+                   vec_multiply(-record->constant,
+                                body_get_velocity(record->body1)));
+  }
+}
+
+/**
+ * Pulls each body down with a force of m g.
+ */
+void force_records_apply_gravity(const force_record_t *records,
+                                 size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const force_record_t *record = &records[i];
+    body_add_force(record->body1,
+                   (vector_t){0, -body_get_mass(record->body1) *
+                                     record->constant});
+  }
+}
+
+void force_records_apply(force_kind_t kind, const force_record_t *records,
+                         size_t count) {
+  switch (kind) {
+  case FORCE_SPRING:
+    force_records_apply_springs(records, count);
+    break;
+  case FORCE_NEWTONIAN_GRAVITY:
+    force_records_apply_newtonian_gravity(records, count);
+    break;
+  case FORCE_DRAG:
+    force_records_apply_drag(records, count);
+    break;
+  case FORCE_GRAVITY:
+    force_records_apply_gravity(records, count);
+    break;
+  default:
+    break;
+  }
+}
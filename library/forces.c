@@ -6,16 +6,11 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
-const double GRAVITY_DISTANCE = 5.0;
-
 typedef struct aux {
   list_t *bodies;
   double *doubles;
-
-  collision_handler_t handler;
-  void *secondary_aux;
-  free_func_t aux_freer;
-  bool collided;
+  // the scene, for forces that move bodies (see scene_set_centroid())
+  scene_t *scene;
 } aux_t;
 
 aux_t *aux_init(int num_bodies, int num_doubles) {
@@ -25,19 +20,13 @@ aux_t *aux_init(int num_bodies, int num_doubles) {
 
   aux->doubles = doubles;
   aux->bodies = bodies;
-
-  aux->secondary_aux = NULL;
-  aux->aux_freer = NULL;
-  aux->collided = false;
+  aux->scene = NULL;
   return aux;
 }
 
 void aux_free(aux_t *aux) {
   free(aux->doubles);
   list_free(aux->bodies);
-  if (aux->aux_freer != NULL && aux->secondary_aux != NULL) {
-    (aux->aux_freer)(aux->secondary_aux);
-  }
   free(aux);
 }
 
@@ -68,70 +57,26 @@ double get_angle(body_t *body1, body_t *body2) {
   return atan2(c2.y - c1.y, c2.x - c1.x);
 }
 
-void apply_newtonian_gravity(aux_t *aux) {
-
-  // Unpack args
-  body_t *body1 = list_get(aux->bodies, 0);
-  body_t *body2 = list_get(aux->bodies, 1);
-  double G = aux->doubles[0];
-
-  double dist = get_distance(body1, body2);
-  if (dist < GRAVITY_DISTANCE) {
-    return;
-  }
-
-  float mag = G * body_get_mass(body1) * body_get_mass(body2) / pow(dist, 2);
-  double angle = get_angle(body1, body2);
-  vector_t v = (vector_t){.x = mag * cos(angle), .y = mag * sin(angle)};
-
-  body_add_force(body1, v);
-  body_add_force(body2, vec_negate(v));
-}
-
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2) {
-
-  // Package args
-  aux_t *aux = aux_init(2, 1);
-  list_add(aux->bodies, body1);
-  list_add(aux->bodies, body2);
-  list_t *bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-  aux->doubles[0] = G;
-
-  scene_add_bodies_force_creator(scene,
-                                 (force_creator_t)apply_newtonian_gravity,
-                                 (void *)aux, bodies, (free_func_t)aux_free);
+  scene_add_force(scene, FORCE_NEWTONIAN_GRAVITY, G, body1, body2);
 }
 
-void apply_spring(aux_t *aux) {
-
-  // Unpack args
-  body_t *body1 = list_get(aux->bodies, 0);
-  body_t *body2 = list_get(aux->bodies, 1);
-  double k = aux->doubles[0];
-
-  float mag = k * get_distance(body1, body2);
-  double angle = get_angle(body1, body2);
-  vector_t v = (vector_t){.x = mag * cos(angle), .y = mag * sin(angle)};
-
-  body_add_force(body1, v);
-  body_add_force(body2, vec_negate(v));
+gravity_group_t *create_gravity_group(scene_t *scene, double G,
+                                      double theta) {
+  gravity_group_t *group = gravity_group_init(G, theta);
+  scene_add_gravity_group(scene, group);
+  return group;
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
+  scene_add_force(scene, FORCE_SPRING, k, body1, body2);
+}
 
-  aux_t *aux = aux_init(2, 1);
-  list_add(aux->bodies, body1);
-  list_add(aux->bodies, body2);
-  list_t *bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-  aux->doubles[0] = k;
-
-  scene_add_bodies_force_creator(scene, (force_creator_t)apply_spring,
-                                 (void *)aux, bodies, (free_func_t)aux_free);
+spring_network_t *create_spring_network(scene_t *scene) {
+  spring_network_t *network = spring_network_init();
+  scene_add_spring_network(scene, network);
+  return network;
 }
 
 void apply_free_on_exit(aux_t *aux) {
@@ -169,21 +114,21 @@ void apply_keep_on_screen(aux_t *aux) {
     if (current_pos.x < 0) {
       vector_t new_centroid =
           (vector_t){current_centroid.x - current_pos.x, current_centroid.y};
-      body_set_centroid(body, new_centroid);
+      scene_set_centroid(aux->scene, body, new_centroid);
     } else if (current_pos.x > max_x) {
       vector_t new_centroid = (vector_t){
           current_centroid.x - current_pos.x + max_x, current_centroid.y};
-      body_set_centroid(body, new_centroid);
+      scene_set_centroid(aux->scene, body, new_centroid);
     }
 
     if (current_pos.y < 0) {
       vector_t new_centroid =
           (vector_t){current_centroid.x, current_centroid.y - current_pos.y};
-      body_set_centroid(body, new_centroid);
+      scene_set_centroid(aux->scene, body, new_centroid);
     } else if (current_pos.x > max_y) {
       vector_t new_centroid = (vector_t){
           current_centroid.x, current_centroid.y - current_pos.y + max_y};
-      body_set_centroid(body, new_centroid);
+      scene_set_centroid(aux->scene, body, new_centroid);
     }
 
     break;
@@ -194,6 +139,7 @@ void create_keep_on_screen(scene_t *scene, double max_x, double max_y,
                            body_t *body) {
   aux_t *aux = aux_init(1, 2);
   list_add(aux->bodies, body);
+  aux->scene = scene;
   list_t *bodies = list_init(1, NULL);
   list_add(bodies, body);
   aux->doubles[0] = max_x;
@@ -202,44 +148,12 @@ void create_keep_on_screen(scene_t *scene, double max_x, double max_y,
                                  (void *)aux, bodies, (free_func_t)aux_free);
 }
 
-void apply_drag(aux_t *aux) {
-
-  // Unpack args
-  body_t *body = list_get(aux->bodies, 0);
-  double gamma = aux->doubles[0];
-
-  body_add_force(body, vec_multiply(-1 * gamma, body_get_velocity(body)));
-}
-
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-
-  aux_t *aux = aux_init(1, 1);
-  list_add(aux->bodies, body);
-  list_t *bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  aux->doubles[0] = gamma;
-  scene_add_bodies_force_creator(scene, (force_creator_t)apply_drag,
-                                 (void *)aux, bodies, (free_func_t)aux_free);
-}
-
-void apply_gravity(aux_t *aux) {
-
-  // Unpack args
-  body_t *body = list_get(aux->bodies, 0);
-  double g = aux->doubles[0];
-
-  body_add_force(body, (vector_t){0, -body_get_mass(body) * g});
+  scene_add_force(scene, FORCE_DRAG, gamma, body, NULL);
 }
 
 void create_gravity(scene_t *scene, double gravity, body_t *body) {
-
-  aux_t *aux = aux_init(1, 1);
-  list_add(aux->bodies, body);
-  list_t *bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  aux->doubles[0] = gravity;
-  scene_add_bodies_force_creator(scene, (force_creator_t)apply_gravity,
-                                 (void *)aux, bodies, (free_func_t)aux_free);
+  scene_add_force(scene, FORCE_GRAVITY, gravity, body, NULL);
 }
 
 void handle_destructive_collision(body_t *body1, body_t *body2, vector_t axis,
@@ -250,20 +164,12 @@ void handle_destructive_collision(body_t *body1, body_t *body2, vector_t axis,
 
 void create_destructive_collision(scene_t *scene, body_t *body1,
                                   body_t *body2) {
-  aux_t *aux = aux_init(2, 0);
-  list_add(aux->bodies, body1);
-  list_add(aux->bodies, body2);
-
-  create_collision(scene, body1, body2,
-                   (collision_handler_t)handle_destructive_collision,
-                   (void *)aux, (void *)aux_free);
+  create_collision(scene, body1, body2, handle_destructive_collision, NULL,
+                   NULL);
 }
 
 void physics_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
 
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
-
   double m1 = body_get_mass(body1);
   double m2 = body_get_mass(body2);
   double v1 = vec_dot(body_get_velocity(body1), axis);
@@ -284,9 +190,6 @@ void physics_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
   vector_t impulse_vec = vec_multiply(impulse, axis);
   body_add_impulse(body1, impulse_vec);
   body_add_impulse(body2, vec_negate(impulse_vec));
-
-  list_free(shape1);
-  list_free(shape2);
 }
 
 void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
@@ -296,44 +199,8 @@ void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
   create_collision(scene, body1, body2, physics_handler, aux, free);
 }
 
-void collision_force_creator(aux_t *aux) {
-
-  body_t *body1 = list_get(aux->bodies, 0);
-  body_t *body2 = list_get(aux->bodies, 1);
-
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
-
-  collision_info_t col = find_collision(shape1, shape2);
-
-  collision_handler_t handler = aux->handler;
-
-  if (col.collided && !aux->collided) {
-    handler(body1, body2, col.axis, aux->secondary_aux);
-    aux->collided = true;
-  } else {
-    aux->collided = false;
-  }
-
-  list_free(shape1);
-  list_free(shape2);
-}
-
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
                       free_func_t freer) {
-  list_t *bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-
-  aux_t *a = aux_init(2, 0);
-  list_add(a->bodies, body1);
-  list_add(a->bodies, body2);
-  a->handler = handler;
-  a->secondary_aux = aux;
-  a->aux_freer = freer;
-
-  scene_add_bodies_force_creator(scene,
-                                 (force_creator_t)collision_force_creator, a,
-                                 bodies, (free_func_t)aux_free);
+  scene_add_pair_collision(scene, body1, body2, handler, aux, freer);
 }
@@ -0,0 +1,339 @@
+#include "gravity_group.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t GRAVITY_GROUP_INITIAL_CAPACITY = 16;
+// bodies closer than this do not attract each other, matching
+// create_newtonian_gravity()
+const double GRAVITY_GROUP_MIN_DISTANCE = 5.0;
+// nodes this deep are not split, so bodies at the same point end up sharing
+// a leaf instead of splitting forever
+const size_t GRAVITY_GROUP_MAX_DEPTH = 32;
+// marks a leaf's lack of children and the end of a leaf's list of bodies
+const size_t GRAVITY_GROUP_NONE = SIZE_MAX;
+
+typedef struct {
+  // the square the node covers
+  vector_t center;
+  double half_width;
+  size_t depth;
+  // the first of the node's four children, or GRAVITY_GROUP_NONE for a leaf
+  size_t children;
+  // the first body in a leaf
+  size_t first_body;
+  double mass;
+  vector_t mass_center;
+} gravity_node_t;
+
+struct gravity_group {
+  double G;
+  double theta;
+  body_t **bodies;
+  size_t count;
+  size_t capacity;
+  // the bodies' positions and masses for the current tick, as parallel
+  // arrays, and the next body in the same leaf
+  double *x;
+  double *y;
+  double *mass;
+  size_t *next;
+  size_t state_capacity;
+  // the tree, rebuilt on each call to gravity_group_apply(); children are
+  // always stored after their parents
+  gravity_node_t *nodes;
+  size_t node_count;
+  size_t node_capacity;
+  // the nodes still to visit while summing the force on a body
+  size_t *stack;
+  size_t stack_capacity;
+};
+
+gravity_group_t *gravity_group_init(double G, double theta) {
+  gravity_group_t *group = malloc(sizeof(gravity_group_t));
+  assert(group);
+  group->G = G;
+  group->theta = theta;
+  group->capacity = GRAVITY_GROUP_INITIAL_CAPACITY;
+  group->bodies = malloc(group->capacity * sizeof(body_t *));
+  assert(group->bodies);
+  group->count = 0;
+  group->x = NULL;
+  group->y = NULL;
+  group->mass = NULL;
+  group->next = NULL;
+  group->state_capacity = 0;
+  group->nodes = NULL;
+  group->node_count = 0;
+  group->node_capacity = 0;
+  group->stack = NULL;
+  group->stack_capacity = 0;
+  return group;
+}
+
+void gravity_group_free(gravity_group_t *group) {
+  free(group->bodies);
+  free(group->x);
+  free(group->y);
+  free(group->mass);
+  free(group->next);
+  free(group->nodes);
+  free(group->stack);
+  free(group);
+}
+
+void gravity_group_add(gravity_group_t *group, body_t *body) {
+  if (group->count == group->capacity) {
+    group->capacity *= 2;
+    group->bodies =
+        realloc(group->bodies, group->capacity * sizeof(body_t *));
+    assert(group->bodies);
+  }
+  group->bodies[group->count++] = body;
+}
+
+size_t gravity_group_size(gravity_group_t *group) { return group->count; }
+
+void gravity_group_set_theta(gravity_group_t *group, double theta) {
+  group->theta = theta;
+}
+
+void gravity_group_remove_dead(gravity_group_t *group) {
+  size_t kept = 0;
+  for (size_t i = 0; i < group->count; i++) {
+    if (!body_is_removed(group->bodies[i])) {
+      group->bodies[kept++] = group->bodies[i];
+    }
+  }
+  group->count = kept;
+}
+
+/**
+ * Makes sure the per-body arrays fit every body.
+ */
+void gravity_group_reserve(gravity_group_t *group) {
+  if (group->state_capacity >= group->count) {
+    return;
+  }
+  group->state_capacity = group->capacity;
+  group->x = realloc(group->x, group->state_capacity * sizeof(double));
+  assert(group->x);
+  group->y = realloc(group->y, group->state_capacity * sizeof(double));
+  assert(group->y);
+  group->mass = realloc(group->mass, group->state_capacity * sizeof(double));
+  assert(group->mass);
+  group->next = realloc(group->next, group->state_capacity * sizeof(size_t));
+  assert(group->next);
+}
+
+/**
+ * Appends a leaf covering a square to the tree.
+ */
+size_t gravity_group_add_node(gravity_group_t *group, vector_t center,
+                              double half_width, size_t depth) {
+  if (group->node_count == group->node_capacity) {
+    group->node_capacity = group->node_capacity == 0
+                               ? GRAVITY_GROUP_INITIAL_CAPACITY
+                               : 2 * group->node_capacity;
+    group->nodes = realloc(group->nodes,
+                           group->node_capacity * sizeof(gravity_node_t));
+    assert(group->nodes);
+  }
+  group->nodes[group->node_count] =
+      (gravity_node_t){center, half_width, depth, GRAVITY_GROUP_NONE,
+                       GRAVITY_GROUP_NONE, 0, VEC_ZERO};
+  return group->node_count++;
+}
+
+/**
+ * Gets the child of a node whose quadrant contains a body.
+ */
+size_t gravity_group_child(gravity_group_t *group, size_t node, size_t body) {
+  gravity_node_t *parent = &group->nodes[node];
+  size_t quadrant = (group->x[body] >= parent->center.x ? 1 : 0) +
+                    (group->y[body] >= parent->center.y ? 2 : 0);
+  return parent->children + quadrant;
+}
+
+/**
+ * Splits a leaf into four children, moving its bodies into them.
+ */
+void gravity_group_split(gravity_group_t *group, size_t node) {
+  gravity_node_t parent = group->nodes[node];
+  double quarter = parent.half_width / 2;
+  size_t children = group->node_count;
+  for (size_t quadrant = 0; quadrant < 4; quadrant++) {
+    vector_t offset = {quadrant & 1 ? quarter : -quarter,
+                       quadrant & 2 ? quarter : -quarter};
+    gravity_group_add_node(group, vec_add(parent.center, offset), quarter,
+                           parent.depth + 1);
+  }
+  group->nodes[node].children = children;
+  group->nodes[node].first_body = GRAVITY_GROUP_NONE;
+
+  size_t body = parent.first_body;
+  while (body != GRAVITY_GROUP_NONE) {
+    size_t next = group->next[body];
+    gravity_node_t *child =
+        &group->nodes[gravity_group_child(group, node, body)];
+    group->next[body] = child->first_body;
+    child->first_body = body;
+    body = next;
+  }
+}
+
+/**
+ * Puts a body in the leaf of the tree covering its position, splitting the
+ * leaf if it already has a body.
+ */
+void gravity_group_insert(gravity_group_t *group, size_t body) {
+  size_t node = 0;
+  while (true) {
+    gravity_node_t *current = &group->nodes[node];
+    if (current->children != GRAVITY_GROUP_NONE) {
+      node = gravity_group_child(group, node, body);
+      continue;
+    }
+    if (current->first_body == GRAVITY_GROUP_NONE ||
+        current->depth == GRAVITY_GROUP_MAX_DEPTH) {
+      group->next[body] = current->first_body;
+      current->first_body = body;
+      return;
+    }
+    gravity_group_split(group, node);
+  }
+}
+
+/**
+ * Sorts the bodies into a new tree and sums the mass under each node.
+ */
+void gravity_group_build(gravity_group_t *group) {
+  vector_t min = {INFINITY, INFINITY};
+  vector_t max = {-INFINITY, -INFINITY};
+  for (size_t i = 0; i < group->count; i++) {
+    vector_t centroid = body_get_centroid(group->bodies[i]);
+    group->x[i] = centroid.x;
+    group->y[i] = centroid.y;
+    group->mass[i] = body_get_mass(group->bodies[i]);
+    min.x = fmin(min.x, centroid.x);
+    min.y = fmin(min.y, centroid.y);
+    max.x = fmax(max.x, centroid.x);
+    max.y = fmax(max.y, centroid.y);
+  }
+
+  group->node_count = 0;
+  double half_width = fmax(max.x - min.x, max.y - min.y) / 2;
+  gravity_group_add_node(group, vec_multiply(0.5, vec_add(min, max)),
+                         half_width, 0);
+  for (size_t i = 0; i < group->count; i++) {
+    gravity_group_insert(group, i);
+  }
+
+  // children come after their parents, so walking backwards finishes every
+  // child before its parent
+  for (size_t i = group->node_count; i > 0; i--) {
+    gravity_node_t *node = &group->nodes[i - 1];
+    double mass = 0;
+    vector_t moment = VEC_ZERO;
+    if (node->children == GRAVITY_GROUP_NONE) {
+      for (size_t body = node->first_body; body != GRAVITY_GROUP_NONE;
+           body = group->next[body]) {
+        mass += group->mass[body];
+        moment.x += group->mass[body] * group->x[body];
+        moment.y += group->mass[body] * group->y[body];
+      }
+    } else {
+      for (size_t quadrant = 0; quadrant < 4; quadrant++) {
+        gravity_node_t *child = &group->nodes[node->children + quadrant];
+        mass += child->mass;
+        moment = vec_add(moment, vec_multiply(child->mass, child->mass_center));
+      }
+    }
+    node->mass = mass;
+    node->mass_center =
+        mass > 0 ? vec_multiply(1 / mass, moment) : node->center;
+  }
+}
+
+/**
+ * Gets the pull of a mass at a point on a unit mass at (x, y), divided by G.
+ */
+vector_t gravity_group_pull(double x, double y, double mass, vector_t point) {
+  double dx = point.x - x;
+  double dy = point.y - y;
+  double distance_squared = dx * dx + dy * dy;
+  if (distance_squared <
+      GRAVITY_GROUP_MIN_DISTANCE * GRAVITY_GROUP_MIN_DISTANCE) {
+    return VEC_ZERO;
+  }
+  double scale = mass / (distance_squared * sqrt(distance_squared));
+  return (vector_t){scale * dx, scale * dy};
+}
+
+/**
+ * Sums the pull on a body from every other body, opening the nodes that are
+ * too close to treat as a single mass.
+ */
+vector_t gravity_group_sum(gravity_group_t *group, size_t body) {
+  double x = group->x[body];
+  double y = group->y[body];
+  double theta_squared = group->theta * group->theta;
+  vector_t pull = VEC_ZERO;
+
+  size_t top = 0;
+  group->stack[top++] = 0;
+  while (top > 0) {
+    gravity_node_t *node = &group->nodes[group->stack[--top]];
+    if (node->mass == 0) {
+      continue;
+    }
+    if (node->children == GRAVITY_GROUP_NONE) {
+      for (size_t other = node->first_body; other != GRAVITY_GROUP_NONE;
+           other = group->next[other]) {
+        if (other != body) {
+          vector_t position = {group->x[other], group->y[other]};
+          pull = vec_add(pull, gravity_group_pull(x, y, group->mass[other],
+                                                  position));
+        }
+      }
+      continue;
+    }
+    double dx = node->mass_center.x - x;
+    double dy = node->mass_center.y - y;
+    double width = 2 * node->half_width;
+    // far enough away: width / distance < theta
+    if (width * width < theta_squared * (dx * dx + dy * dy)) {
+      pull = vec_add(pull,
+                     gravity_group_pull(x, y, node->mass, node->mass_center));
+      continue;
+    }
+    for (size_t quadrant = 0; quadrant < 4; quadrant++) {
+      group->stack[top++] = node->children + quadrant;
+    }
+  }
+  return pull;
+}
+
+void gravity_group_apply(gravity_group_t *group) {
+  if (group->count < 2) {
+    return;
+  }
+  gravity_group_reserve(group);
+  gravity_group_build(group);
+
+  // each level of the walk leaves at most 3 siblings on the stack
+  size_t stack_size = 3 * (GRAVITY_GROUP_MAX_DEPTH + 1) + 1;
+  if (group->stack_capacity < stack_size) {
+    group->stack_capacity = stack_size;
+    group->stack = realloc(group->stack, stack_size * sizeof(size_t));
+    assert(group->stack);
+  }
+
+  for (size_t i = 0; i < group->count; i++) {
+    vector_t pull = gravity_group_sum(group, i);
+    body_add_force(group->bodies[i],
+                   vec_multiply(group->G * group->mass[i], pull));
+  }
+}
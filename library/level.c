@@ -15,6 +15,12 @@ const double PROJ_SPEED = 200;
 
 const double SCREEN_WIDTH = 800.0;
 const double SCREEN_HEIGHT = 800.0;
+// the seconds between an enemy's attacks
+const double ENEMY_ATTACK_PERIOD = 1.0;
+const vector_t ENEMY_PROJECTILE_VELOCITY = {0, -100};
+// enough for every enemy on screen to keep firing until its shots fall off
+const size_t ENEMY_PROJECTILE_CAPACITY = 256;
+const double ENEMY_PROJECTILE_LIFETIME = 8.0;
 
 int parse_int(char c) { return (int)c + ASCII_INT_CONVERSION; }
 
@@ -142,7 +148,13 @@ body_t *render_scene(scene_t *scene, list_t *level, double scroll_speed) {
   body_t *bg = sprite_init(INFINITY, BACKGROUND,
                            "/assets/level_1_sprites/level1_bg.png", 2125, 800);
   body_set_velocity(bg, (vector_t){scroll_speed / -4.0, 0});
+  body_set_collision_filter(bg, 0, 0);
   scene_add_body(scene, bg);
+  scene_set_projectiles(
+      scene, BALL,
+      projectile_pool_init(ENEMY_PROJECTILE_CAPACITY, BLOCK_WIDTH,
+                           ENEMY_PROJECTILE_LIFETIME,
+                           "assets/level_1_sprites/ball.png"));
   for (int i = 0; i < width / BLOCK_WIDTH + 1; i++) {
     render_info_t *info =
         render_column(scene, level, i, scroll_speed, VEC_ZERO);
@@ -156,6 +168,27 @@ body_t *render_scene(scene_t *scene, list_t *level, double scroll_speed) {
   return player;
 }
 
+/**
+ * Fires a projectile from an enemy's emitter and turns the enemy around,
+ * then waits for its next attack.
+ * Has the signature of a timer_callback_t taking the scene as aux.
+ */
+void render_fire_emitter(body_t *enemy, void *aux) {
+  scene_t *scene = aux;
+  emitter_component_t *emitter = component_store_get(
+      scene_get_components(scene), COMPONENT_EMITTER, enemy);
+  if (emitter == NULL || body_is_removed(enemy)) {
+    return;
+  }
+  projectile_pool_t *pool = scene_get_projectiles(scene, emitter->projectile);
+  if (pool != NULL) {
+    projectile_pool_spawn(pool, body_get_centroid(enemy), emitter->velocity);
+  }
+  scene_set_velocity(scene, enemy, vec_multiply(-1, body_get_velocity(enemy)));
+  scene_schedule(scene, enemy, ENEMY_ATTACK_PERIOD, render_fire_emitter,
+                 scene);
+}
+
 render_info_t *render_column(scene_t *scene, list_t *level, size_t column,
                              double scroll_speed, vector_t absolute_origin) {
   body_t *player = NULL; // stores player if in column
@@ -177,12 +210,16 @@ render_info_t *render_column(scene_t *scene, list_t *level, size_t column,
         player = block;
       } else if (body_type == FIREBALL || body_type == WATERBALL) {
         body_set_velocity(block, (vector_t){-1 * PROJ_SPEED, 0});
-      } else if (body_type == GOOMBA || body_type == CRAB) {
-        obstacle_info_t *info = body_get_info(block);
       } else if (body_type == THOMP) {
         body_set_velocity(block, (vector_t){0, -1 * PROJ_SPEED});
       } else if (body_type == SPACESHIP || body_type == SUBMARINE) {
         body_set_velocity(block, (vector_t){-1 * PROJ_SPEED, 0});
+        emitter_component_t *emitter = component_store_add(
+            scene_get_components(scene), COMPONENT_EMITTER, block);
+        emitter->projectile = BALL;
+        emitter->velocity = ENEMY_PROJECTILE_VELOCITY;
+        scene_schedule(scene, block, ENEMY_ATTACK_PERIOD, render_fire_emitter,
+                       scene);
       }
     }
   }
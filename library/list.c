@@ -53,6 +53,14 @@ void *list_get(list_t *list, size_t index) {
   return list->data[index];
 }
 
+void *list_set(list_t *list, size_t index, void *value) {
+  assert(index < list->size);
+  assert(value != NULL);
+  void *old = list->data[index];
+  list->data[index] = value;
+  return old;
+}
+
 void ensure_capacity(list_t *list) {
   if (list->size + 1 > list->capacity) {
     if (list->capacity == 0) {
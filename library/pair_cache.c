@@ -0,0 +1,58 @@
+#include "pair_cache.h"
+#include "body_table.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t PAIR_CACHE_INITIAL_CAPACITY = 64;
+
+struct pair_cache {
+  // a table of pair_entry_t, which starts with its two bodies as the key
+  body_table_t *entries;
+};
+
+pair_cache_t *pair_cache_init(void) {
+  pair_cache_t *cache = malloc(sizeof(pair_cache_t));
+  assert(cache);
+  cache->entries =
+      body_table_init(sizeof(pair_entry_t), PAIR_CACHE_INITIAL_CAPACITY);
+  return cache;
+}
+
+void pair_cache_free(pair_cache_t *cache) {
+  body_table_free(cache->entries);
+  free(cache);
+}
+
+size_t pair_cache_size(pair_cache_t *cache) {
+  return body_table_size(cache->entries);
+}
+
+pair_entry_t *pair_cache_touch(pair_cache_t *cache, body_t *body1,
+                               body_t *body2, size_t tick) {
+  assert(body1 != NULL && body2 != NULL);
+  pair_entry_t *entry = body_table_add(cache->entries, body1, body2);
+  entry->last_seen = tick;
+  return entry;
+}
+
+size_t pair_cache_sweep(pair_cache_t *cache, size_t tick, pair_expire_t expire,
+                        void *aux) {
+  size_t dropped = 0;
+  size_t i = 0;
+  while (i < body_table_capacity(cache->entries)) {
+    pair_entry_t *entry = body_table_get_slot(cache->entries, i);
+    if (entry != NULL &&
+        (entry->last_seen != tick || body_is_removed(entry->body1) ||
+         body_is_removed(entry->body2))) {
+      if (expire != NULL) {
+        expire(entry, aux);
+      }
+      // another entry may be shifted into this slot, so look at it again
+      body_table_remove(cache->entries, entry);
+      dropped++;
+    } else {
+      i++;
+    }
+  }
+  return dropped;
+}
@@ -0,0 +1,254 @@
+#include "projectile_pool.h"
+#include "sdl_wrapper.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+struct projectile_pool {
+  size_t capacity;
+  double radius;
+  double lifetime;
+  SDL_Texture *texture;
+  // the state of the projectile in each slot, as parallel arrays
+  double *x;
+  double *y;
+  double *velocity_x;
+  double *velocity_y;
+  // the value of time at which the projectile expires
+  double *expiry;
+  bool *alive;
+  // the slot of the oldest projectile; the rest follow it around the ring
+  size_t head;
+  size_t size;
+  size_t live;
+  // the seconds the pool has been advanced through
+  double time;
+  aabb_t bounds;
+  uint32_t target_categories;
+  projectile_handler_t handler;
+  void *aux;
+  uint32_t solid_categories;
+};
+
+const aabb_t PROJECTILE_EMPTY_BOUNDS = {{INFINITY, INFINITY},
+                                        {-INFINITY, -INFINITY}};
+
+projectile_pool_t *projectile_pool_init(size_t capacity, double radius,
+                                        double lifetime,
+                                        const char *texture_path) {
+  assert(capacity > 0);
+  projectile_pool_t *pool = malloc(sizeof(projectile_pool_t));
+  assert(pool);
+  pool->capacity = capacity;
+  pool->radius = radius;
+  pool->lifetime = lifetime;
+  pool->texture =
+      texture_path == NULL ? NULL : sdl_create_texture((char *)texture_path);
+  pool->x = malloc(capacity * sizeof(double));
+  assert(pool->x);
+  pool->y = malloc(capacity * sizeof(double));
+  assert(pool->y);
+  pool->velocity_x = malloc(capacity * sizeof(double));
+  assert(pool->velocity_x);
+  pool->velocity_y = malloc(capacity * sizeof(double));
+  assert(pool->velocity_y);
+  pool->expiry = malloc(capacity * sizeof(double));
+  assert(pool->expiry);
+  pool->alive = malloc(capacity * sizeof(bool));
+  assert(pool->alive);
+  pool->head = 0;
+  pool->size = 0;
+  pool->live = 0;
+  pool->time = 0;
+  pool->bounds = PROJECTILE_EMPTY_BOUNDS;
+  pool->target_categories = 0;
+  pool->handler = NULL;
+  pool->aux = NULL;
+  pool->solid_categories = 0;
+  return pool;
+}
+
+void projectile_pool_free(projectile_pool_t *pool) {
+  if (pool->texture != NULL) {
+    SDL_DestroyTexture(pool->texture);
+  }
+  free(pool->x);
+  free(pool->y);
+  free(pool->velocity_x);
+  free(pool->velocity_y);
+  free(pool->expiry);
+  free(pool->alive);
+  free(pool);
+}
+
+void projectile_pool_set_targets(projectile_pool_t *pool,
+                                 uint32_t target_categories,
+                                 projectile_handler_t handler, void *aux,
+                                 uint32_t solid_categories) {
+  pool->target_categories = target_categories;
+  pool->handler = handler;
+  pool->aux = aux;
+  pool->solid_categories = solid_categories;
+}
+
+/**
+ * Gets the slot of the projectile with a given index.
+ */
+size_t projectile_pool_slot(projectile_pool_t *pool, size_t index) {
+  size_t slot = pool->head + index;
+  return slot < pool->capacity ? slot : slot - pool->capacity;
+}
+
+/**
+ * Grows a box to cover a projectile centered at a point.
+ */
+aabb_t projectile_pool_cover(aabb_t bounds, double x, double y,
+                             double radius) {
+  bounds.min.x = fmin(bounds.min.x, x - radius);
+  bounds.min.y = fmin(bounds.min.y, y - radius);
+  bounds.max.x = fmax(bounds.max.x, x + radius);
+  bounds.max.y = fmax(bounds.max.y, y + radius);
+  return bounds;
+}
+
+void projectile_pool_spawn(projectile_pool_t *pool, vector_t position,
+                           vector_t velocity) {
+  size_t slot;
+  if (pool->size == pool->capacity) {
+    // recycle the oldest projectile
+    slot = pool->head;
+    pool->head = projectile_pool_slot(pool, 1);
+    if (pool->alive[slot]) {
+      pool->live--;
+    }
+  } else {
+    slot = projectile_pool_slot(pool, pool->size);
+    pool->size++;
+  }
+  pool->x[slot] = position.x;
+  pool->y[slot] = position.y;
+  pool->velocity_x[slot] = velocity.x;
+  pool->velocity_y[slot] = velocity.y;
+  pool->expiry[slot] = pool->time + pool->lifetime;
+  pool->alive[slot] = true;
+  pool->live++;
+  pool->bounds =
+      projectile_pool_cover(pool->bounds, position.x, position.y, pool->radius);
+}
+
+size_t projectile_pool_size(projectile_pool_t *pool) { return pool->size; }
+
+size_t projectile_pool_live(projectile_pool_t *pool) { return pool->live; }
+
+bool projectile_pool_is_alive(projectile_pool_t *pool, size_t index) {
+  assert(index < pool->size);
+  return pool->alive[projectile_pool_slot(pool, index)];
+}
+
+vector_t projectile_pool_get_position(projectile_pool_t *pool, size_t index) {
+  assert(index < pool->size);
+  size_t slot = projectile_pool_slot(pool, index);
+  return (vector_t){pool->x[slot], pool->y[slot]};
+}
+
+double projectile_pool_get_radius(projectile_pool_t *pool) {
+  return pool->radius;
+}
+
+SDL_Texture *projectile_pool_get_texture(projectile_pool_t *pool) {
+  return pool->texture;
+}
+
+aabb_t projectile_pool_get_bounds(projectile_pool_t *pool) {
+  return pool->bounds;
+}
+
+uint32_t projectile_pool_get_mask(projectile_pool_t *pool) {
+  return pool->target_categories | pool->solid_categories;
+}
+
+/**
+ * Moves the projectiles in the slots [start, end) and grows a box to cover
+ * the live ones.
+ */
+aabb_t projectile_pool_integrate(projectile_pool_t *pool, size_t start,
+                                 size_t end, double dt, aabb_t bounds) {
+  double *x = pool->x;
+  double *y = pool->y;
+  const double *velocity_x = pool->velocity_x;
+  const double *velocity_y = pool->velocity_y;
+  // destroyed projectiles move too, which keeps this loop branch-free
+  for (size_t i = start; i < end; i++) {
+    x[i] += velocity_x[i] * dt;
+    y[i] += velocity_y[i] * dt;
+  }
+  for (size_t i = start; i < end; i++) {
+    if (pool->alive[i]) {
+      bounds = projectile_pool_cover(bounds, x[i], y[i], pool->radius);
+    }
+  }
+  return bounds;
+}
+
+void projectile_pool_advance(projectile_pool_t *pool, double dt) {
+  pool->time += dt;
+  // the oldest projectiles expire first; destroyed ones can go with them
+  while (pool->size > 0 && (!pool->alive[pool->head] ||
+                            pool->expiry[pool->head] <= pool->time)) {
+    if (pool->alive[pool->head]) {
+      pool->live--;
+    }
+    pool->head = projectile_pool_slot(pool, 1);
+    pool->size--;
+  }
+
+  // the ring covers at most two runs of consecutive slots
+  aabb_t bounds = PROJECTILE_EMPTY_BOUNDS;
+  size_t end = pool->head + pool->size;
+  if (end <= pool->capacity) {
+    bounds = projectile_pool_integrate(pool, pool->head, end, dt, bounds);
+  } else {
+    bounds = projectile_pool_integrate(pool, pool->head, pool->capacity, dt,
+                                       bounds);
+    bounds = projectile_pool_integrate(pool, 0, end - pool->capacity, dt,
+                                       bounds);
+  }
+  pool->bounds = bounds;
+}
+
+void projectile_pool_collide(projectile_pool_t *pool, body_t *body) {
+  uint32_t category = body_get_collision_category(body);
+  if (pool->live == 0 || (category & projectile_pool_get_mask(pool)) == 0 ||
+      body_is_sensor(body) || body_is_removed(body)) {
+    return;
+  }
+  aabb_t box = body_get_aabb(body);
+  if (!aabb_overlap(box, pool->bounds)) {
+    return;
+  }
+  box = aabb_expand(box, pool->radius, VEC_ZERO);
+  collision_shape_t shape = body_get_collision_shape(body);
+  vector_t center = VEC_ZERO;
+  vector_t normal = VEC_ZERO;
+  collision_shape_t projectile = {1,           &center, &normal, VEC_ZERO,
+                                  SHAPE_CIRCLE, pool->radius};
+  bool target = (category & pool->target_categories) != 0;
+
+  for (size_t index = 0; index < pool->size; index++) {
+    size_t i = projectile_pool_slot(pool, index);
+    // reject by the body's box grown by the radius before building a shape
+    if (!pool->alive[i] || pool->x[i] < box.min.x || pool->x[i] > box.max.x ||
+        pool->y[i] < box.min.y || pool->y[i] > box.max.y) {
+      continue;
+    }
+    projectile.centroid = (vector_t){pool->x[i], pool->y[i]};
+    if (!find_shape_overlap(&projectile, &shape)) {
+      continue;
+    }
+    pool->alive[i] = false;
+    pool->live--;
+    if (target && pool->handler != NULL) {
+      pool->handler(body, projectile.centroid, pool->aux);
+    }
+  }
+}
@@ -1,10 +1,29 @@
 #include "scene.h"
+#include "contact_solver.h"
+#include "pair_cache.h"
 #include "sdl_wrapper.h"
+#include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 
 int const BODY_COUNT = 200;
 int const FORCES_COUNT = 200;
 int const TEXT_COUNT = 10;
+int const CHARACTER_COUNT = 4;
+int const TYPE_BODY_COUNT = 8;
+int const QUERY_COUNT = 16;
+const size_t FIELD_COUNT = 4;
+const size_t FORCE_RECORD_COUNT = 16;
+int const GRAVITY_GROUP_COUNT = 2;
+int const SPRING_NETWORK_COUNT = 2;
+const size_t COMMAND_COUNT = 16;
+// the radius scene_query_nearest() starts searching within, doubled until
+// enough bodies are found
+const double NEAREST_INITIAL_RADIUS = 64;
+// how far past a character's path to look for obstacles moving into it
+const double CHARACTER_QUERY_MARGIN = 4;
+// the length of a tick of the timing wheel, in seconds
+const double SCENE_TIMER_RESOLUTION = 1.0 / 60;
 
 typedef struct scene_force {
   force_creator_t forcer;
@@ -21,12 +40,186 @@ void scene_force_free(scene_force_t *scene_force) {
   free(scene_force);
 }
 
+typedef struct scene_collision {
+  // at most one of the handlers is set
+  collision_handler_t handler;
+  contact_handler_t contact_handler;
+  void *aux;
+  free_func_t aux_freer;
+  // the response of the contact solver, stored under both orders of the
+  // types and kept when the handlers are replaced
+  bool solid;
+  double elasticity;
+  double friction;
+} scene_collision_t;
+
+/**
+ * Clears the handlers of an entry of the collision table, freeing its aux.
+ */
+void scene_collision_clear(scene_collision_t *collision) {
+  if (collision->aux_freer != NULL && collision->aux != NULL) {
+    collision->aux_freer(collision->aux);
+  }
+  collision->handler = NULL;
+  collision->contact_handler = NULL;
+  collision->aux = NULL;
+  collision->aux_freer = NULL;
+}
+
+/**
+ * A growable array of the built-in forces of one kind.
+ */
+typedef struct force_records {
+  force_record_t *records;
+  size_t count;
+  size_t capacity;
+} force_records_t;
+
+/**
+ * A handler for collisions between two particular bodies, see
+ * scene_add_pair_collision().
+ */
+typedef struct pair_collision {
+  body_t *body1;
+  body_t *body2;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t aux_freer;
+  // whether the bodies were colliding on the last tick
+  bool collided;
+  separating_axis_cache_t axis_cache;
+} pair_collision_t;
+
+/**
+ * Frees the aux of a pair collision handler.
+ */
+void pair_collision_clear(pair_collision_t *collision) {
+  if (collision->aux_freer != NULL && collision->aux != NULL) {
+    collision->aux_freer(collision->aux);
+  }
+}
+
+/**
+ * The changes to a scene that are put off until the end of a tick.
+ */
+typedef enum {
+  SCENE_COMMAND_ADD_BODY,
+  SCENE_COMMAND_ADD_FORCE_CREATOR,
+  SCENE_COMMAND_ADD_FORCE,
+  SCENE_COMMAND_ADD_PAIR_COLLISION,
+  SCENE_COMMAND_ADD_COLLISION_HANDLER,
+  SCENE_COMMAND_ADD_CONTACT_HANDLER,
+  SCENE_COMMAND_REMOVE_BODY,
+  SCENE_COMMAND_SET_CENTROID,
+  SCENE_COMMAND_SET_VELOCITY,
+} scene_command_kind_t;
+
+/**
+ * A change to a scene requested during a tick, with the arguments of the
+ * call that requested it; each kind uses only some of the fields.
+ */
+typedef struct scene_command {
+  scene_command_kind_t kind;
+  body_t *body1;
+  body_t *body2;
+  // the force kind and constant of SCENE_COMMAND_ADD_FORCE
+  force_kind_t force_kind;
+  double constant;
+  // the centroid or velocity to set
+  vector_t vector;
+  // the body types of a collision or contact handler
+  body_type_t type1;
+  body_type_t type2;
+  force_creator_t forcer;
+  collision_handler_t handler;
+  contact_handler_t contact_handler;
+  list_t *bodies;
+  void *aux;
+  free_func_t aux_freer;
+} scene_command_t;
+
+/**
+ * A growable array of pairs of bodies, stored as consecutive bodies.
+ */
+typedef struct body_pairs {
+  body_t **bodies;
+  size_t count;
+  size_t capacity;
+} body_pairs_t;
+
+/**
+ * Appends a pair of bodies to an array of pairs.
+ * Has the signature of a body_pair_handler_t taking the array as aux.
+ */
+void body_pairs_add(body_t *body1, body_t *body2, void *aux) {
+  body_pairs_t *pairs = aux;
+  if (2 * (pairs->count + 1) > pairs->capacity) {
+    pairs->capacity =
+        pairs->capacity == 0 ? (size_t)BODY_COUNT : 2 * pairs->capacity;
+    pairs->bodies = realloc(pairs->bodies, pairs->capacity * sizeof(body_t *));
+    assert(pairs->bodies);
+  }
+  pairs->bodies[2 * pairs->count] = body1;
+  pairs->bodies[2 * pairs->count + 1] = body2;
+  pairs->count++;
+}
+
 struct scene {
   list_t *bodies;
   list_t *forces;
   list_t *texts;
+  list_t *characters;
+  // the bodies of each type, in no particular order
+  list_t *bodies_by_type[BODY_TYPE_COUNT];
+  component_store_t *components;
+  timer_wheel_t *timers;
+  // the projectiles of each type; NULL for types without a pool
+  projectile_pool_t *projectiles[BODY_TYPE_COUNT];
+  force_field_t *fields;
+  size_t field_count;
+  size_t field_capacity;
+  // the built-in forces of each kind, see scene_add_force()
+  force_records_t force_records[FORCE_KIND_COUNT];
+  list_t *gravity_groups;
+  list_t *spring_networks;
+  // whether scene_tick() is running, so changes must wait for the sync
+  // point; see scene_apply_commands()
+  bool ticking;
+  scene_command_t *commands;
+  size_t command_count;
+  size_t command_capacity;
+  pair_collision_t *pair_collisions;
+  size_t pair_collision_count;
+  size_t pair_collision_capacity;
   size_t width;
   size_t height;
+  narrow_phase_t narrow_phase;
+  broad_phase_t *broad_phase; // NULL for BROAD_PHASE_NONE
+  // pairs found by scene_find_pairs()
+  body_pairs_t pairs;
+  // pairs that need the narrow phase, and its inputs and outputs for each
+  body_pairs_t narrow_pairs;
+  pair_entry_t **narrow_entries;
+  separating_axis_cache_t **narrow_caches;
+  // the first shapes of the pairs, followed by the second shapes
+  collision_shape_t *narrow_shapes;
+  collision_info_t *narrow_infos;
+  size_t narrow_capacity;
+  // pairs involving a sensor, checked after the other collisions
+  body_pairs_t sensor_pairs;
+  // touching pairs for the contact solver
+  body_pairs_t solid_pairs;
+  contact_constraint_t *constraints;
+  size_t constraints_capacity;
+  size_t solver_iterations;
+  // collision handler for each (type1, type2), at type1 * BODY_TYPE_COUNT +
+  // type2; NULL until a handler is added
+  scene_collision_t *collisions;
+  // state of the pairs found by the broad phase, see scene_tick()
+  pair_cache_t *pairs_seen;
+  size_t ticks;
+  // length of the current (or last) tick, for sweeping bullets
+  double dt;
 };
 
 scene_t *scene_init(size_t width, size_t height) {
@@ -38,15 +231,97 @@ scene_t *scene_init(size_t width, size_t height) {
   scene->bodies = bodies;
   scene->forces = forces;
   scene->texts = texts;
+  scene->characters =
+      list_init(CHARACTER_COUNT, (free_func_t)character_free);
+  for (size_t i = 0; i < BODY_TYPE_COUNT; i++) {
+    scene->bodies_by_type[i] = list_init(TYPE_BODY_COUNT, NULL);
+    scene->projectiles[i] = NULL;
+  }
+  scene->components = component_store_init();
+  scene->timers = timer_wheel_init(SCENE_TIMER_RESOLUTION);
+  scene->fields = NULL;
+  scene->field_count = 0;
+  scene->field_capacity = 0;
+  for (size_t i = 0; i < FORCE_KIND_COUNT; i++) {
+    scene->force_records[i] = (force_records_t){NULL, 0, 0};
+  }
+  scene->gravity_groups =
+      list_init(GRAVITY_GROUP_COUNT, (free_func_t)gravity_group_free);
+  scene->spring_networks =
+      list_init(SPRING_NETWORK_COUNT, (free_func_t)spring_network_free);
+  scene->ticking = false;
+  scene->commands = NULL;
+  scene->command_count = 0;
+  scene->command_capacity = 0;
+  scene->pair_collisions = NULL;
+  scene->pair_collision_count = 0;
+  scene->pair_collision_capacity = 0;
   scene->width = width;
   scene->height = height;
+  scene->narrow_phase = NARROW_PHASE_SAT;
+  scene->broad_phase = NULL;
+  scene->pairs = (body_pairs_t){NULL, 0, 0};
+  scene->narrow_pairs = (body_pairs_t){NULL, 0, 0};
+  scene->narrow_entries = NULL;
+  scene->narrow_caches = NULL;
+  scene->narrow_shapes = NULL;
+  scene->narrow_infos = NULL;
+  scene->narrow_capacity = 0;
+  scene->sensor_pairs = (body_pairs_t){NULL, 0, 0};
+  scene->solid_pairs = (body_pairs_t){NULL, 0, 0};
+  scene->constraints = NULL;
+  scene->constraints_capacity = 0;
+  scene->solver_iterations = CONTACT_SOLVER_ITERATIONS;
+  scene->collisions = NULL;
+  scene->pairs_seen = pair_cache_init();
+  scene->ticks = 0;
+  scene->dt = 0;
   return scene;
 }
 
 void scene_free(scene_t *scene) {
+  if (scene->broad_phase != NULL) {
+    broad_phase_free(scene->broad_phase);
+  }
+  free(scene->pairs.bodies);
+  free(scene->narrow_pairs.bodies);
+  free(scene->narrow_entries);
+  free(scene->narrow_caches);
+  free(scene->narrow_shapes);
+  free(scene->narrow_infos);
+  free(scene->sensor_pairs.bodies);
+  free(scene->solid_pairs.bodies);
+  free(scene->constraints);
+  if (scene->collisions != NULL) {
+    for (size_t i = 0; i < BODY_TYPE_COUNT * BODY_TYPE_COUNT; i++) {
+      scene_collision_clear(&scene->collisions[i]);
+    }
+    free(scene->collisions);
+  }
+  pair_cache_free(scene->pairs_seen);
   list_free(scene->forces);
   list_free(scene->bodies);
   list_free(scene->texts);
+  list_free(scene->characters);
+  for (size_t i = 0; i < BODY_TYPE_COUNT; i++) {
+    list_free(scene->bodies_by_type[i]);
+    if (scene->projectiles[i] != NULL) {
+      projectile_pool_free(scene->projectiles[i]);
+    }
+  }
+  component_store_free(scene->components);
+  timer_wheel_free(scene->timers);
+  free(scene->fields);
+  for (size_t i = 0; i < FORCE_KIND_COUNT; i++) {
+    free(scene->force_records[i].records);
+  }
+  list_free(scene->gravity_groups);
+  list_free(scene->spring_networks);
+  free(scene->commands);
+  for (size_t i = 0; i < scene->pair_collision_count; i++) {
+    pair_collision_clear(&scene->pair_collisions[i]);
+  }
+  free(scene->pair_collisions);
   free(scene);
 }
 
@@ -56,17 +331,166 @@ body_t *scene_get_body(scene_t *scene, size_t index) {
   return list_get(scene->bodies, index);
 }
 
+/**
+ * Queues a change to apply at the end of the current tick.
+ */
+void scene_defer(scene_t *scene, scene_command_t command) {
+  if (scene->command_count == scene->command_capacity) {
+    scene->command_capacity = scene->command_capacity == 0
+                                  ? COMMAND_COUNT
+                                  : 2 * scene->command_capacity;
+    scene->commands = realloc(scene->commands, scene->command_capacity *
+                                                   sizeof(scene_command_t));
+    assert(scene->commands);
+  }
+  scene->commands[scene->command_count++] = command;
+}
+
 void scene_add_body(scene_t *scene, body_t *body) {
+  if (scene->ticking) {
+    scene_defer(scene, (scene_command_t){.kind = SCENE_COMMAND_ADD_BODY,
+                                         .body1 = body});
+    return;
+  }
+  list_t *of_type = scene->bodies_by_type[body_get_type(body)];
+  body_set_type_index(body, list_size(of_type));
   list_add(scene->bodies, body);
+  list_add(of_type, body);
+  if (scene->broad_phase != NULL) {
+    broad_phase_add(scene->broad_phase, body);
+  }
+}
+
+size_t scene_bodies_of_type(scene_t *scene, body_type_t type) {
+  return list_size(scene->bodies_by_type[type]);
+}
+
+body_t *scene_get_body_of_type(scene_t *scene, body_type_t type,
+                               size_t index) {
+  return list_get(scene->bodies_by_type[type], index);
+}
+
+component_store_t *scene_get_components(scene_t *scene) {
+  return scene->components;
+}
+
+timer_handle_t scene_schedule(scene_t *scene, body_t *body, double delay,
+                              timer_callback_t callback, void *aux) {
+  timer_handle_t handle =
+      timer_wheel_schedule(scene->timers, delay, callback, body, aux);
+  if (body != NULL) {
+    timer_component_t *timer =
+        component_store_get(scene->components, COMPONENT_TIMER, body);
+    if (timer == NULL) {
+      timer = component_store_add(scene->components, COMPONENT_TIMER, body);
+    } else {
+      timer_wheel_cancel(scene->timers, timer->timer);
+    }
+    timer->timer = handle;
+  }
+  return handle;
+}
+
+void scene_cancel_timer(scene_t *scene, timer_handle_t handle) {
+  timer_wheel_cancel(scene->timers, handle);
+}
+
+void scene_set_projectiles(scene_t *scene, body_type_t type,
+                           projectile_pool_t *pool) {
+  if (scene->projectiles[type] != NULL) {
+    projectile_pool_free(scene->projectiles[type]);
+  }
+  scene->projectiles[type] = pool;
+}
+
+projectile_pool_t *scene_get_projectiles(scene_t *scene, body_type_t type) {
+  return scene->projectiles[type];
+}
+
+size_t scene_add_force_field(scene_t *scene, force_field_t field) {
+  if (scene->field_count == scene->field_capacity) {
+    scene->field_capacity =
+        scene->field_capacity == 0 ? FIELD_COUNT : 2 * scene->field_capacity;
+    scene->fields = realloc(scene->fields,
+                            scene->field_capacity * sizeof(force_field_t));
+    assert(scene->fields);
+  }
+  scene->fields[scene->field_count] = field;
+  return scene->field_count++;
+}
+
+size_t scene_force_fields(scene_t *scene) { return scene->field_count; }
+
+force_field_t *scene_get_force_field(scene_t *scene, size_t index) {
+  assert(index < scene->field_count);
+  return &scene->fields[index];
+}
+
+void scene_add_gravity_group(scene_t *scene, gravity_group_t *group) {
+  list_add(scene->gravity_groups, group);
+}
+
+void scene_add_spring_network(scene_t *scene, spring_network_t *network) {
+  list_add(scene->spring_networks, network);
+}
+
+/**
+ * Drops a body that is about to be freed from the list of its type.
+ */
+void scene_unindex_body(scene_t *scene, body_t *body) {
+  list_t *bodies = scene->bodies_by_type[body_get_type(body)];
+  // move the last body of the type into the removed body's place
+  size_t index = body_get_type_index(body);
+  assert(list_get(bodies, index) == body);
+  body_t *last = list_remove(bodies, list_size(bodies) - 1);
+  if (last != body) {
+    list_set(bodies, index, last);
+    body_set_type_index(last, index);
+  }
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
-  body_remove(scene_get_body(scene, index));
+  body_t *body = scene_get_body(scene, index);
+  if (scene->ticking) {
+    scene_defer(scene, (scene_command_t){.kind = SCENE_COMMAND_REMOVE_BODY,
+                                         .body1 = body});
+    return;
+  }
+  body_remove(body);
+}
+
+void scene_set_centroid(scene_t *scene, body_t *body, vector_t centroid) {
+  if (scene->ticking) {
+    scene_defer(scene, (scene_command_t){.kind = SCENE_COMMAND_SET_CENTROID,
+                                         .body1 = body,
+                                         .vector = centroid});
+    return;
+  }
+  body_set_centroid(body, centroid);
+}
+
+void scene_set_velocity(scene_t *scene, body_t *body, vector_t velocity) {
+  if (scene->ticking) {
+    scene_defer(scene, (scene_command_t){.kind = SCENE_COMMAND_SET_VELOCITY,
+                                         .body1 = body,
+                                         .vector = velocity});
+    return;
+  }
+  body_set_velocity(body, velocity);
 }
 
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer) {
+  if (scene->ticking) {
+    scene_defer(scene,
+                (scene_command_t){.kind = SCENE_COMMAND_ADD_FORCE_CREATOR,
+                                  .forcer = forcer,
+                                  .bodies = bodies,
+                                  .aux = aux,
+                                  .aux_freer = freer});
+    return;
+  }
   scene_force_t *force = malloc(sizeof(scene_force_t));
   force->forcer = forcer;
   force->aux = aux;
@@ -76,20 +500,681 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
   list_add(scene->forces, force);
 }
 
+void scene_add_force(scene_t *scene, force_kind_t kind, double constant,
+                     body_t *body1, body_t *body2) {
+  assert(kind < FORCE_KIND_COUNT);
+  if (scene->ticking) {
+    scene_defer(scene, (scene_command_t){.kind = SCENE_COMMAND_ADD_FORCE,
+                                         .body1 = body1,
+                                         .body2 = body2,
+                                         .force_kind = kind,
+                                         .constant = constant});
+    return;
+  }
+  force_records_t *forces = &scene->force_records[kind];
+  if (forces->count == forces->capacity) {
+    forces->capacity =
+        forces->capacity == 0 ? FORCE_RECORD_COUNT : 2 * forces->capacity;
+    forces->records =
+        realloc(forces->records, forces->capacity * sizeof(force_record_t));
+    assert(forces->records);
+  }
+  forces->records[forces->count++] =
+      (force_record_t){body1, body2, constant};
+}
+
+void scene_add_pair_collision(scene_t *scene, body_t *body1, body_t *body2,
+                              collision_handler_t handler, void *aux,
+                              free_func_t freer) {
+  if (scene->ticking) {
+    scene_defer(scene,
+                (scene_command_t){.kind = SCENE_COMMAND_ADD_PAIR_COLLISION,
+                                  .body1 = body1,
+                                  .body2 = body2,
+                                  .handler = handler,
+                                  .aux = aux,
+                                  .aux_freer = freer});
+    return;
+  }
+  if (scene->pair_collision_count == scene->pair_collision_capacity) {
+    scene->pair_collision_capacity =
+        scene->pair_collision_capacity == 0
+            ? FORCE_RECORD_COUNT
+            : 2 * scene->pair_collision_capacity;
+    scene->pair_collisions =
+        realloc(scene->pair_collisions,
+                scene->pair_collision_capacity * sizeof(pair_collision_t));
+    assert(scene->pair_collisions);
+  }
+  scene->pair_collisions[scene->pair_collision_count++] = (pair_collision_t){
+      body1, body2, handler, aux, freer, false, (separating_axis_cache_t){0}};
+}
+
+void scene_add_character(scene_t *scene, character_t *character) {
+  list_add(scene->characters, character);
+}
+
 void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
                              free_func_t freer) {
   scene_add_bodies_force_creator(scene, forcer, aux, NULL, freer);
 }
 
+/**
+ * Gets the entry of the collision table for a pair of types, creating the
+ * table if needed.
+ */
+scene_collision_t *scene_collision_entry(scene_t *scene, body_type_t type1,
+                                         body_type_t type2) {
+  assert(type1 < BODY_TYPE_COUNT && type2 < BODY_TYPE_COUNT);
+  if (scene->collisions == NULL) {
+    scene->collisions = calloc(BODY_TYPE_COUNT * BODY_TYPE_COUNT,
+                               sizeof(scene_collision_t));
+    assert(scene->collisions);
+  }
+  return &scene->collisions[type1 * BODY_TYPE_COUNT + type2];
+}
+
+/**
+ * Replaces the handlers for a pair of types.
+ */
+scene_collision_t *scene_set_collision(scene_t *scene, body_type_t type1,
+                                       body_type_t type2, void *aux,
+                                       free_func_t freer) {
+  scene_collision_clear(scene_collision_entry(scene, type2, type1));
+  scene_collision_t *collision = scene_collision_entry(scene, type1, type2);
+  scene_collision_clear(collision);
+  collision->aux = aux;
+  collision->aux_freer = freer;
+  return collision;
+}
+
+void scene_add_solid_collision(scene_t *scene, body_type_t type1,
+                               body_type_t type2, double elasticity,
+                               double friction) {
+  scene_collision_t *collisions[2] = {
+      scene_collision_entry(scene, type1, type2),
+      scene_collision_entry(scene, type2, type1)};
+  for (size_t i = 0; i < 2; i++) {
+    collisions[i]->solid = true;
+    collisions[i]->elasticity = elasticity;
+    collisions[i]->friction = friction;
+  }
+}
+
+void scene_set_solver_iterations(scene_t *scene, size_t iterations) {
+  scene->solver_iterations = iterations;
+}
+
+void scene_add_collision_handler(scene_t *scene, body_type_t type1,
+                                 body_type_t type2,
+                                 collision_handler_t handler, void *aux,
+                                 free_func_t freer) {
+  // replacing a handler frees its aux, which may be in use mid-dispatch
+  if (scene->ticking) {
+    scene_defer(scene,
+                (scene_command_t){.kind = SCENE_COMMAND_ADD_COLLISION_HANDLER,
+                                  .type1 = type1,
+                                  .type2 = type2,
+                                  .handler = handler,
+                                  .aux = aux,
+                                  .aux_freer = freer});
+    return;
+  }
+  scene_set_collision(scene, type1, type2, aux, freer)->handler = handler;
+}
+
+void scene_add_contact_handler(scene_t *scene, body_type_t type1,
+                               body_type_t type2, contact_handler_t handler,
+                               void *aux, free_func_t freer) {
+  if (scene->ticking) {
+    scene_defer(scene,
+                (scene_command_t){.kind = SCENE_COMMAND_ADD_CONTACT_HANDLER,
+                                  .type1 = type1,
+                                  .type2 = type2,
+                                  .contact_handler = handler,
+                                  .aux = aux,
+                                  .aux_freer = freer});
+    return;
+  }
+  scene_set_collision(scene, type1, type2, aux, freer)->contact_handler =
+      handler;
+}
+
+/**
+ * Calls whichever handler is registered with a contact event, if any.
+ * Collision handlers only hear about pairs that are touching.
+ */
+void scene_notify(scene_collision_t *collision, body_t *body1, body_t *body2,
+                  contact_event_t event, vector_t axis) {
+  if (collision == NULL) {
+    return;
+  }
+  if (collision->contact_handler != NULL) {
+    collision->contact_handler(body1, body2, event, axis, collision->aux);
+  } else if (collision->handler != NULL && event != CONTACT_END) {
+    collision->handler(body1, body2, axis, collision->aux);
+  }
+}
+
+/**
+ * Gets the handlers for a pair of types, if any.
+ */
+scene_collision_t *scene_get_collision(scene_t *scene, body_type_t type1,
+                                       body_type_t type2) {
+  scene_collision_t *collision =
+      &scene->collisions[type1 * BODY_TYPE_COUNT + type2];
+  if (collision->handler == NULL && collision->contact_handler == NULL) {
+    return NULL;
+  }
+  return collision;
+}
+
+/**
+ * Records whether a pair is touching after this tick's check and notifies
+ * its handlers of the change.
+ */
+void scene_update_contact(scene_collision_t *collision, pair_entry_t *pair,
+                          bool touching, vector_t axis) {
+  bool was_touching = pair->touching;
+  pair->touching = touching;
+  if (touching) {
+    contact_event_t event = was_touching ? CONTACT_PERSIST : CONTACT_BEGIN;
+    scene_notify(collision, pair->body1, pair->body2, event, axis);
+  } else if (was_touching) {
+    scene_notify(collision, pair->body1, pair->body2, CONTACT_END, axis);
+  }
+}
+
+/**
+ * Gets the box a body covers during the current tick, which for a bullet
+ * includes its whole path.
+ */
+aabb_t scene_body_aabb(scene_t *scene, body_t *body) {
+  aabb_t aabb = body_get_aabb(body);
+  if (body_is_bullet(body)) {
+    aabb = aabb_expand(aabb, 0, body_get_displacement(body, scene->dt));
+  }
+  return aabb;
+}
+
+/**
+ * Checks whether a pair that is not touching will touch during the current
+ * tick, if either body is a bullet.
+ */
+time_of_impact_t scene_sweep_pair(scene_t *scene, body_t *body1,
+                                  const collision_shape_t *shape1,
+                                  body_t *body2,
+                                  const collision_shape_t *shape2) {
+  if (!body_is_bullet(body1) && !body_is_bullet(body2)) {
+    return (time_of_impact_t){false, 1, VEC_ZERO, true};
+  }
+  return find_time_of_impact(shape1, body_get_displacement(body1, scene->dt),
+                             shape2, body_get_displacement(body2, scene->dt));
+}
+
+/**
+ * Puts a pair from the broad phase in the order its handler expects and
+ * queues it for the narrow phase, or for the sensor pass if either body is a
+ * sensor. Pairs that no handler or contact response cares about are dropped.
+ */
+void scene_collect_pair(body_t *body1, body_t *body2, void *aux) {
+  scene_t *scene = aux;
+  if (!body_filters_collide(body1, body2) || body_is_removed(body1) ||
+      body_is_removed(body2)) {
+    return;
+  }
+  body_type_t type1 = body_get_type(body1);
+  body_type_t type2 = body_get_type(body2);
+  scene_collision_t *response =
+      &scene->collisions[type1 * BODY_TYPE_COUNT + type2];
+  // put the bodies in the order the handler expects; bodies of the same type
+  // are ordered by address, and bodies without a handler by type, so each
+  // pair is always checked the same way round
+  bool swap;
+  scene_collision_t *collision = scene_get_collision(scene, type1, type2);
+  if (type1 == type2) {
+    swap = body2 < body1;
+  } else if (collision == NULL) {
+    collision = scene_get_collision(scene, type2, type1);
+    swap = collision != NULL || type2 < type1;
+  } else {
+    swap = false;
+  }
+  if (collision == NULL && !response->solid) {
+    return;
+  }
+  if (swap) {
+    body_t *other = body1;
+    body1 = body2;
+    body2 = other;
+  }
+
+  // sensors only need an overlap test, which is left for a separate pass;
+  // they never push other bodies
+  if (body_is_sensor(body1) || body_is_sensor(body2)) {
+    if (collision != NULL) {
+      body_pairs_add(body1, body2, &scene->sensor_pairs);
+    }
+    return;
+  }
+  // add the pair to the cache now, so its entry stays put while the pairs
+  // are checked
+  pair_cache_touch(scene->pairs_seen, body1, body2, scene->ticks);
+  body_pairs_add(body1, body2, &scene->narrow_pairs);
+}
+
+/**
+ * Makes sure the narrow phase's arrays fit every pair found this tick.
+ */
+void scene_reserve_narrow_phase(scene_t *scene) {
+  if (scene->narrow_pairs.count <= scene->narrow_capacity) {
+    return;
+  }
+  size_t capacity = scene->narrow_pairs.capacity;
+  scene->narrow_capacity = capacity;
+  scene->narrow_entries =
+      realloc(scene->narrow_entries, capacity * sizeof(pair_entry_t *));
+  assert(scene->narrow_entries);
+  scene->narrow_caches = realloc(
+      scene->narrow_caches, capacity * sizeof(separating_axis_cache_t *));
+  assert(scene->narrow_caches);
+  scene->narrow_shapes = realloc(scene->narrow_shapes,
+                                 2 * capacity * sizeof(collision_shape_t));
+  assert(scene->narrow_shapes);
+  scene->narrow_infos =
+      realloc(scene->narrow_infos, capacity * sizeof(collision_info_t));
+  assert(scene->narrow_infos);
+}
+
+/**
+ * Runs the narrow phase on the pairs found by scene_collect_pair() in one
+ * batch, then, pair by pair, notifies the handlers registered for their
+ * types of any change in contact and queues touching solid pairs for the
+ * contact solver.
+ */
+void scene_dispatch_collisions(scene_t *scene) {
+  body_pairs_t *pairs = &scene->narrow_pairs;
+  scene_reserve_narrow_phase(scene);
+  collision_shape_t *shapes1 = scene->narrow_shapes;
+  collision_shape_t *shapes2 = scene->narrow_shapes + pairs->count;
+  for (size_t i = 0; i < pairs->count; i++) {
+    body_t *body1 = pairs->bodies[2 * i];
+    body_t *body2 = pairs->bodies[2 * i + 1];
+    // every pair is already in the cache, so these entries stay put
+    pair_entry_t *pair =
+        pair_cache_touch(scene->pairs_seen, body1, body2, scene->ticks);
+    scene->narrow_entries[i] = pair;
+    scene->narrow_caches[i] = &pair->axis_cache;
+    shapes1[i] = body_get_collision_shape(body1);
+    shapes2[i] = body_get_collision_shape(body2);
+  }
+  find_shape_collisions(scene->narrow_phase, pairs->count, shapes1, shapes2,
+                        scene->narrow_caches, scene->narrow_infos);
+
+  for (size_t i = 0; i < pairs->count; i++) {
+    body_t *body1 = pairs->bodies[2 * i];
+    body_t *body2 = pairs->bodies[2 * i + 1];
+    // an earlier handler may have removed one of the bodies
+    if (body_is_removed(body1) || body_is_removed(body2)) {
+      continue;
+    }
+    body_type_t type1 = body_get_type(body1);
+    body_type_t type2 = body_get_type(body2);
+    scene_collision_t *response =
+        &scene->collisions[type1 * BODY_TYPE_COUNT + type2];
+    scene_collision_t *collision = scene_get_collision(scene, type1, type2);
+    pair_entry_t *pair = scene->narrow_entries[i];
+    collision_info_t info = scene->narrow_infos[i];
+    if (response->solid) {
+      contact_solver_update_manifold(
+          pair, find_contact_manifold(&shapes1[i], &shapes2[i], info));
+      if (pair->manifold.count > 0) {
+        body_pairs_add(body1, body2, &scene->solid_pairs);
+      }
+    }
+    if (!info.collided) {
+      time_of_impact_t impact =
+          scene_sweep_pair(scene, body1, &shapes1[i], body2, &shapes2[i]);
+      info.collided = impact.hit;
+      if (impact.hit) {
+        info.axis = impact.axis;
+      }
+    }
+    scene_update_contact(collision, pair, info.collided, info.axis);
+  }
+  pairs->count = 0;
+}
+
+/**
+ * Checks the pairs involving a sensor found by scene_collect_pair().
+ * Their bodies are already in the order the handlers expect.
+ */
+void scene_dispatch_sensors(scene_t *scene) {
+  for (size_t i = 0; i < scene->sensor_pairs.count; i++) {
+    body_t *body1 = scene->sensor_pairs.bodies[2 * i];
+    body_t *body2 = scene->sensor_pairs.bodies[2 * i + 1];
+    if (body_is_removed(body1) || body_is_removed(body2)) {
+      continue;
+    }
+    scene_collision_t *collision = scene_get_collision(
+        scene, body_get_type(body1), body_get_type(body2));
+    pair_entry_t *pair =
+        pair_cache_touch(scene->pairs_seen, body1, body2, scene->ticks);
+    collision_shape_t shape1 = body_get_collision_shape(body1);
+    collision_shape_t shape2 = body_get_collision_shape(body2);
+    bool overlap = find_shape_overlap(&shape1, &shape2) ||
+                   scene_sweep_pair(scene, body1, &shape1, body2, &shape2).hit;
+    scene_update_contact(collision, pair, overlap, VEC_ZERO);
+  }
+  scene->sensor_pairs.count = 0;
+}
+
+/**
+ * Runs the contact solver on the solid pairs found by
+ * scene_dispatch_collisions().
+ */
+void scene_solve_contacts(scene_t *scene, double dt) {
+  body_pairs_t *pairs = &scene->solid_pairs;
+  if (pairs->count > scene->constraints_capacity) {
+    scene->constraints_capacity = pairs->capacity;
+    scene->constraints =
+        realloc(scene->constraints,
+                scene->constraints_capacity * sizeof(contact_constraint_t));
+    assert(scene->constraints);
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < pairs->count; i++) {
+    body_t *body1 = pairs->bodies[2 * i];
+    body_t *body2 = pairs->bodies[2 * i + 1];
+    if (body_is_removed(body1) || body_is_removed(body2)) {
+      continue;
+    }
+    scene_collision_t *response = &scene->collisions
+        [body_get_type(body1) * BODY_TYPE_COUNT + body_get_type(body2)];
+    // every pair is already in the cache, so these entries stay put
+    pair_entry_t *pair =
+        pair_cache_touch(scene->pairs_seen, body1, body2, scene->ticks);
+    scene->constraints[count++] = (contact_constraint_t){
+        pair, response->elasticity, response->friction, 0};
+  }
+  contact_solver_solve(scene->constraints, count, dt,
+                       scene->solver_iterations);
+  pairs->count = 0;
+}
+
+/**
+ * Offers a body found near a character to it as an obstacle.
+ */
+bool scene_add_obstacle(body_t *body, void *aux) {
+  character_add_obstacle(aux, body);
+  return true;
+}
+
+/**
+ * Sweeps each character through the bodies around its path, dropping the
+ * characters whose bodies are being removed.
+ * Without a broad phase, every body is offered to every character, which
+ * rejects the distant ones by their swept boxes.
+ */
+void scene_sweep_characters(scene_t *scene, double dt) {
+  for (size_t i = list_size(scene->characters); i > 0; i--) {
+    character_t *character = list_get(scene->characters, i - 1);
+    body_t *body = character_get_body(character);
+    if (body_is_removed(body)) {
+      list_remove(scene->characters, i - 1);
+      character_free(character);
+      continue;
+    }
+    if (scene->broad_phase != NULL) {
+      aabb_t path = aabb_expand(body_get_aabb(body), CHARACTER_QUERY_MARGIN,
+                                body_get_displacement(body, dt));
+      broad_phase_query(scene->broad_phase, path, scene_add_obstacle,
+                        character);
+    } else {
+      for (size_t j = 0; j < scene_bodies(scene); j++) {
+        character_add_obstacle(character, scene_get_body(scene, j));
+      }
+    }
+    character_sweep(character, dt);
+  }
+}
+
+/**
+ * Checks the projectiles of a pool against a body found near them.
+ */
+bool scene_collide_projectiles(body_t *body, void *aux) {
+  projectile_pool_t *pool = aux;
+  projectile_pool_collide(pool, body);
+  return projectile_pool_live(pool) > 0;
+}
+
+/**
+ * Moves the projectiles of each pool, then checks them against the bodies
+ * around them.
+ * Without a broad phase, every body is checked, and the pool rejects the
+ * bodies outside the box around its projectiles.
+ */
+void scene_tick_projectiles(scene_t *scene, double dt) {
+  for (size_t i = 0; i < BODY_TYPE_COUNT; i++) {
+    projectile_pool_t *pool = scene->projectiles[i];
+    if (pool == NULL) {
+      continue;
+    }
+    projectile_pool_advance(pool, dt);
+    if (projectile_pool_live(pool) == 0) {
+      continue;
+    }
+    if (scene->broad_phase != NULL) {
+      broad_phase_query(scene->broad_phase, projectile_pool_get_bounds(pool),
+                        scene_collide_projectiles, pool);
+    } else {
+      for (size_t j = 0; j < scene_bodies(scene); j++) {
+        projectile_pool_collide(pool, scene_get_body(scene, j));
+      }
+    }
+  }
+}
+
+/**
+ * Ends the contact of a touching pair that the broad phase stopped
+ * reporting or that has a body about to be freed.
+ */
+void scene_expire_pair(pair_entry_t *pair, void *aux) {
+  scene_t *scene = aux;
+  if (!pair->touching) {
+    return;
+  }
+  scene_collision_t *collision = scene_get_collision(
+      scene, body_get_type(pair->body1), body_get_type(pair->body2));
+  scene_notify(collision, pair->body1, pair->body2, CONTACT_END, VEC_ZERO);
+}
+
+/**
+ * Calls the handlers of the pairs of bodies that started colliding.
+ */
+void scene_check_pair_collisions(scene_t *scene) {
+  for (size_t i = 0; i < scene->pair_collision_count; i++) {
+    pair_collision_t *collision = &scene->pair_collisions[i];
+    // bodies whose fat boxes are apart cannot be touching
+    if (!scene_bodies_may_collide(scene, collision->body1, collision->body2)) {
+      collision->collided = false;
+      continue;
+    }
+    collision_shape_t shape1 = body_get_collision_shape(collision->body1);
+    collision_shape_t shape2 = body_get_collision_shape(collision->body2);
+    collision_info_t info = find_shape_collision_with(
+        scene->narrow_phase, &shape1, &shape2, &collision->axis_cache);
+    bool started = info.collided && !collision->collided;
+    collision->collided = info.collided;
+    if (started) {
+      collision->handler(collision->body1, collision->body2, info.axis,
+                         collision->aux);
+    }
+  }
+}
+
+/**
+ * The sync point of a tick: makes the changes requested since the tick
+ * started, in the order they were requested.
+ * Changes requested after this point are made right away.
+ */
+void scene_apply_commands(scene_t *scene) {
+  scene->ticking = false;
+  for (size_t i = 0; i < scene->command_count; i++) {
+    scene_command_t *command = &scene->commands[i];
+    switch (command->kind) {
+    case SCENE_COMMAND_ADD_BODY:
+      scene_add_body(scene, command->body1);
+      break;
+    case SCENE_COMMAND_ADD_FORCE_CREATOR:
+      scene_add_bodies_force_creator(scene, command->forcer, command->aux,
+                                     command->bodies, command->aux_freer);
+      break;
+    case SCENE_COMMAND_ADD_FORCE:
+      scene_add_force(scene, command->force_kind, command->constant,
+                      command->body1, command->body2);
+      break;
+    case SCENE_COMMAND_ADD_PAIR_COLLISION:
+      scene_add_pair_collision(scene, command->body1, command->body2,
+                               command->handler, command->aux,
+                               command->aux_freer);
+      break;
+    case SCENE_COMMAND_ADD_COLLISION_HANDLER:
+      scene_add_collision_handler(scene, command->type1, command->type2,
+                                  command->handler, command->aux,
+                                  command->aux_freer);
+      break;
+    case SCENE_COMMAND_ADD_CONTACT_HANDLER:
+      scene_add_contact_handler(scene, command->type1, command->type2,
+                                command->contact_handler, command->aux,
+                                command->aux_freer);
+      break;
+    case SCENE_COMMAND_REMOVE_BODY:
+      body_remove(command->body1);
+      break;
+    case SCENE_COMMAND_SET_CENTROID:
+      body_set_centroid(command->body1, command->vector);
+      break;
+    case SCENE_COMMAND_SET_VELOCITY:
+      body_set_velocity(command->body1, command->vector);
+      break;
+    }
+  }
+  scene->command_count = 0;
+}
+
+/**
+ * Drops the built-in forces and pair collisions involving removed bodies,
+ * keeping the rest in order, and takes removed bodies out of the gravity
+ * groups and spring networks.
+ */
+void scene_remove_dead_forces(scene_t *scene) {
+  for (size_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    force_records_t *forces = &scene->force_records[kind];
+    size_t kept = 0;
+    for (size_t i = 0; i < forces->count; i++) {
+      force_record_t *record = &forces->records[i];
+      if (body_is_removed(record->body1) ||
+          (record->body2 != NULL && body_is_removed(record->body2))) {
+        continue;
+      }
+      forces->records[kept++] = *record;
+    }
+    forces->count = kept;
+  }
+  for (size_t i = 0; i < list_size(scene->gravity_groups); i++) {
+    gravity_group_remove_dead(list_get(scene->gravity_groups, i));
+  }
+  for (size_t i = 0; i < list_size(scene->spring_networks); i++) {
+    spring_network_remove_dead(list_get(scene->spring_networks, i));
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < scene->pair_collision_count; i++) {
+    pair_collision_t *collision = &scene->pair_collisions[i];
+    if (body_is_removed(collision->body1) ||
+        body_is_removed(collision->body2)) {
+      pair_collision_clear(collision);
+      continue;
+    }
+    scene->pair_collisions[kept++] = *collision;
+  }
+  scene->pair_collision_count = kept;
+}
+
 void scene_tick(scene_t *scene, double dt) {
+  scene->dt = dt;
+  // until the sync point, the scene's arrays keep their size
+  scene->ticking = true;
+
+  // fire the timers that are due (note timers can schedule more timers)
+  timer_wheel_advance(scene->timers, dt);
+
+  // apply the force fields to every body in one pass
+  if (scene->field_count > 0) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+      body_t *body = scene_get_body(scene, i);
+      body_add_force(body, force_fields_get_force(
+                               scene->fields, scene->field_count, body));
+    }
+  }
 
-  // apply all forces (note forces can add more forces)
-  for (size_t i = 0; i < list_size(scene->forces); i++) {
+  // apply the built-in forces kind by kind, then check the pair collisions
+  for (size_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    force_records_t *forces = &scene->force_records[kind];
+    force_records_apply(kind, forces->records, forces->count);
+  }
+  for (size_t i = 0; i < list_size(scene->gravity_groups); i++) {
+    gravity_group_apply(list_get(scene->gravity_groups, i));
+  }
+  for (size_t i = 0; i < list_size(scene->spring_networks); i++) {
+    spring_network_apply(list_get(scene->spring_networks, i));
+  }
+  scene_check_pair_collisions(scene);
+
+  // apply all forces
+  size_t force_count = list_size(scene->forces);
+  for (size_t i = 0; i < force_count; i++) {
     scene_force_t *force = list_get(scene->forces, i);
     force->forcer(force->aux);
   }
 
-  // remove force_creators of marked bodies
+  // dispatch collisions through the handler table
+  if (scene->collisions != NULL) {
+    scene->ticks++;
+    // the boxes of bullets must cover their paths over this tick
+    if (scene->broad_phase != NULL) {
+      for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        if (body_is_bullet(body)) {
+          broad_phase_update_body(scene->broad_phase, body, dt);
+        }
+      }
+    }
+    scene_find_pairs(scene, scene_collect_pair, scene);
+    scene_dispatch_collisions(scene);
+    scene_dispatch_sensors(scene);
+    scene_solve_contacts(scene, dt);
+  }
+
+  // plan the characters' moves now that every impulse has been applied
+  scene_sweep_characters(scene, dt);
+  scene_tick_projectiles(scene, dt);
+  scene_apply_commands(scene);
+
+  // end the contacts of pairs that were not found this tick or whose bodies
+  // are about to be freed, so the cache never holds a freed body; ending a
+  // contact can remove more bodies, so sweep until nothing is dropped
+  if (scene->collisions != NULL) {
+    bool dropped = true;
+    while (dropped) {
+      dropped = pair_cache_sweep(scene->pairs_seen, scene->ticks,
+                                 scene_expire_pair, scene) > 0;
+    }
+  }
+
+  // remove forces of marked bodies
+  scene_remove_dead_forces(scene);
   for (size_t j = 0; j < list_size(scene->forces); j++) {
     scene_force_t *force = list_get(scene->forces, j);
     if (force->bodies != NULL) {
@@ -111,9 +1196,349 @@ void scene_tick(scene_t *scene, double dt) {
     body_tick(body, dt);
     if (body_is_removed(body)) {
       list_remove(scene->bodies, i - 1);
+      scene_unindex_body(scene, body);
+      timer_component_t *timer =
+          component_store_get(scene->components, COMPONENT_TIMER, body);
+      if (timer != NULL) {
+        timer_wheel_cancel(scene->timers, timer->timer);
+      }
+      component_store_remove_body(scene->components, body);
+      if (scene->broad_phase != NULL) {
+        broad_phase_remove(scene->broad_phase, body);
+      }
       body_free(body);
     }
   }
+
+  for (size_t i = 0; i < list_size(scene->characters); i++) {
+    character_finish(list_get(scene->characters, i));
+  }
+
+  if (scene->broad_phase != NULL) {
+    broad_phase_update(scene->broad_phase, dt);
+  }
+}
+
+void scene_set_narrow_phase(scene_t *scene, narrow_phase_t narrow_phase) {
+  scene->narrow_phase = narrow_phase;
+}
+
+narrow_phase_t scene_get_narrow_phase(scene_t *scene) {
+  return scene->narrow_phase;
+}
+
+void scene_set_broad_phase(scene_t *scene, broad_phase_kind_t broad_phase) {
+  if (scene->broad_phase != NULL) {
+    broad_phase_free(scene->broad_phase);
+    scene->broad_phase = NULL;
+  }
+  if (broad_phase == BROAD_PHASE_NONE) {
+    return;
+  }
+  scene->broad_phase = broad_phase_init(broad_phase);
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    broad_phase_add(scene->broad_phase, scene_get_body(scene, i));
+  }
+}
+
+broad_phase_kind_t scene_get_broad_phase(scene_t *scene) {
+  if (scene->broad_phase == NULL) {
+    return BROAD_PHASE_NONE;
+  }
+  return broad_phase_get_kind(scene->broad_phase);
+}
+
+bool scene_bodies_may_collide(scene_t *scene, body_t *body1, body_t *body2) {
+  if (scene->broad_phase == NULL) {
+    return true;
+  }
+  return broad_phase_test_overlap(scene->broad_phase, body1, body2);
+}
+
+void scene_find_pairs(scene_t *scene, body_pair_handler_t handler, void *aux) {
+  scene->pairs.count = 0;
+  if (scene->broad_phase != NULL) {
+    broad_phase_find_pairs(scene->broad_phase, body_pairs_add, &scene->pairs);
+  } else {
+    size_t count = scene_bodies(scene);
+    for (size_t i = 0; i < count; i++) {
+      body_t *body1 = scene_get_body(scene, i);
+      aabb_t aabb1 = scene_body_aabb(scene, body1);
+      for (size_t j = i + 1; j < count; j++) {
+        body_t *body2 = scene_get_body(scene, j);
+        if (aabb_overlap(aabb1, scene_body_aabb(scene, body2))) {
+          body_pairs_add(body1, body2, &scene->pairs);
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < scene->pairs.count; i++) {
+    handler(scene->pairs.bodies[2 * i], scene->pairs.bodies[2 * i + 1], aux);
+  }
+}
+
+/**
+ * The bodies a query has to run the narrow phase on.
+ */
+typedef struct {
+  uint32_t mask;
+  // the only type the query finds, or BODY_TYPE_COUNT for any type
+  body_type_t type;
+  // a body the query must not find, or NULL
+  body_t *exclude;
+  list_t *bodies;
+  // how many bodies the broad phase found, whether or not they were kept
+  size_t seen;
+} scene_query_t;
+
+/**
+ * Starts a query that keeps the bodies that pass its filters.
+ */
+scene_query_t scene_query_init(uint32_t mask, body_type_t type,
+                               body_t *exclude) {
+  return (scene_query_t){mask, type, exclude, list_init(QUERY_COUNT, NULL), 0};
+}
+
+/**
+ * Keeps a body found by the broad phase if the query's filter accepts it.
+ */
+bool scene_query_add(body_t *body, void *aux) {
+  scene_query_t *query = aux;
+  query->seen++;
+  if (body != query->exclude && !body_is_removed(body) &&
+      (body_get_collision_category(body) & query->mask) != 0 &&
+      (query->type == BODY_TYPE_COUNT || body_get_type(body) == query->type)) {
+    list_add(query->bodies, body);
+  }
+  return true;
+}
+
+/**
+ * Finds the bodies whose boxes overlap bounds, using the broad phase if
+ * there is one.
+ */
+void scene_query_bounds(scene_t *scene, aabb_t bounds, scene_query_t *query) {
+  if (scene->broad_phase != NULL) {
+    broad_phase_query(scene->broad_phase, bounds, scene_query_add, query);
+    return;
+  }
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (aabb_overlap(body_get_aabb(body), bounds)) {
+      scene_query_add(body, query);
+    }
+  }
+}
+
+/**
+ * Orders hits by their fractions.
+ */
+int scene_compare_hits(const void *hit1, const void *hit2) {
+  double fraction1 = ((const scene_hit_t *)hit1)->fraction;
+  double fraction2 = ((const scene_hit_t *)hit2)->fraction;
+  return (fraction1 > fraction2) - (fraction1 < fraction2);
+}
+
+/**
+ * Sorts an array of hits and moves them into a list, freeing the array.
+ */
+list_t *scene_sort_hits(scene_hit_t *hits, size_t count) {
+  qsort(hits, count, sizeof(scene_hit_t), scene_compare_hits);
+  list_t *sorted = list_init(count > 0 ? count : 1, free);
+  for (size_t i = 0; i < count; i++) {
+    scene_hit_t *hit = malloc(sizeof(scene_hit_t));
+    assert(hit);
+    *hit = hits[i];
+    list_add(sorted, hit);
+  }
+  free(hits);
+  return sorted;
+}
+
+/**
+ * Allocates space for one hit on each body a query found.
+ */
+scene_hit_t *scene_hits_init(scene_query_t *query) {
+  size_t count = list_size(query->bodies);
+  scene_hit_t *hits = malloc((count > 0 ? count : 1) * sizeof(scene_hit_t));
+  assert(hits);
+  return hits;
+}
+
+list_t *scene_raycast(scene_t *scene, vector_t origin, vector_t translation,
+                      uint32_t mask) {
+  scene_query_t query = scene_query_init(mask, BODY_TYPE_COUNT, NULL);
+  if (scene->broad_phase != NULL) {
+    broad_phase_raycast(scene->broad_phase, origin, translation,
+                        scene_query_add, &query);
+  } else {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+      body_t *body = scene_get_body(scene, i);
+      if (aabb_ray_overlap(body_get_aabb(body), origin, translation)) {
+        scene_query_add(body, &query);
+      }
+    }
+  }
+
+  scene_hit_t *hits = scene_hits_init(&query);
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(query.bodies); i++) {
+    body_t *body = list_get(query.bodies, i);
+    collision_shape_t shape = body_get_collision_shape(body);
+    time_of_impact_t impact =
+        find_ray_intersection(&shape, origin, translation);
+    if (impact.hit) {
+      vector_t point = vec_add(origin, vec_multiply(impact.time, translation));
+      hits[count++] = (scene_hit_t){body, impact.time, point, impact.axis};
+    }
+  }
+  list_free(query.bodies);
+  return scene_sort_hits(hits, count);
+}
+
+list_t *scene_shape_cast(scene_t *scene, body_t *body, vector_t translation,
+                         uint32_t mask) {
+  scene_query_t query = scene_query_init(mask, BODY_TYPE_COUNT, body);
+  aabb_t path = aabb_expand(body_get_aabb(body), 0, translation);
+  scene_query_bounds(scene, path, &query);
+
+  collision_shape_t shape = body_get_collision_shape(body);
+  scene_hit_t *hits = scene_hits_init(&query);
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(query.bodies); i++) {
+    body_t *other = list_get(query.bodies, i);
+    collision_shape_t other_shape = body_get_collision_shape(other);
+    time_of_impact_t impact =
+        find_time_of_impact(&shape, translation, &other_shape, VEC_ZERO);
+    if (impact.hit) {
+      vector_t point =
+          vec_add(shape.centroid, vec_multiply(impact.time, translation));
+      hits[count++] =
+          (scene_hit_t){other, impact.time, point, vec_negate(impact.axis)};
+    }
+  }
+  list_free(query.bodies);
+  return scene_sort_hits(hits, count);
+}
+
+list_t *scene_overlap_aabb(scene_t *scene, aabb_t aabb, uint32_t mask) {
+  scene_query_t query = scene_query_init(mask, BODY_TYPE_COUNT, NULL);
+  scene_query_bounds(scene, aabb, &query);
+
+  // sort by squared distance from the center, reusing the hit ordering
+  vector_t center = vec_multiply(0.5, vec_add(aabb.min, aabb.max));
+  scene_hit_t *hits = scene_hits_init(&query);
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(query.bodies); i++) {
+    body_t *body = list_get(query.bodies, i);
+    // the broad phase only compares fat boxes
+    if (aabb_overlap(body_get_aabb(body), aabb)) {
+      vector_t offset = vec_subtract(body_get_centroid(body), center);
+      hits[count++] = (scene_hit_t){body, vec_dot(offset, offset), center,
+                                    VEC_ZERO};
+    }
+  }
+  list_free(query.bodies);
+  qsort(hits, count, sizeof(scene_hit_t), scene_compare_hits);
+  list_t *bodies = list_init(count > 0 ? count : 1, NULL);
+  for (size_t i = 0; i < count; i++) {
+    list_add(bodies, hits[i].body);
+  }
+  free(hits);
+  return bodies;
+}
+
+/**
+ * Orders neighbors by their squared distances.
+ */
+int scene_compare_neighbors(const void *neighbor1, const void *neighbor2) {
+  double distance1 = ((const scene_neighbor_t *)neighbor1)->distance_squared;
+  double distance2 = ((const scene_neighbor_t *)neighbor2)->distance_squared;
+  return (distance1 > distance2) - (distance1 < distance2);
+}
+
+/**
+ * The bodies of a type within some radius of a point, nearest first.
+ */
+typedef struct {
+  scene_neighbor_t *neighbors;
+  size_t count;
+  // whether every body in the scene was looked at, so there are no others
+  bool complete;
+} scene_neighbors_t;
+
+/**
+ * Finds the bodies of a type whose centroids are within radius of center.
+ */
+scene_neighbors_t scene_find_neighbors(scene_t *scene, vector_t center,
+                                       double radius, body_type_t type) {
+  scene_query_t query = scene_query_init(~(uint32_t)0, type, NULL);
+  aabb_t bounds = {vec_subtract(center, (vector_t){radius, radius}),
+                   vec_add(center, (vector_t){radius, radius})};
+  if (scene->broad_phase != NULL) {
+    broad_phase_query(scene->broad_phase, bounds, scene_query_add, &query);
+  } else {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+      scene_query_add(scene_get_body(scene, i), &query);
+    }
+  }
+
+  size_t found = list_size(query.bodies);
+  scene_neighbors_t result = {
+      malloc((found > 0 ? found : 1) * sizeof(scene_neighbor_t)), 0,
+      query.seen == scene_bodies(scene)};
+  assert(result.neighbors);
+  for (size_t i = 0; i < found; i++) {
+    body_t *body = list_get(query.bodies, i);
+    vector_t offset = vec_subtract(body_get_centroid(body), center);
+    double distance_squared = vec_dot(offset, offset);
+    if (distance_squared <= radius * radius) {
+      result.neighbors[result.count++] =
+          (scene_neighbor_t){body, distance_squared};
+    }
+  }
+  list_free(query.bodies);
+  qsort(result.neighbors, result.count, sizeof(scene_neighbor_t),
+        scene_compare_neighbors);
+  return result;
+}
+
+/**
+ * Moves the first count neighbors into a list, freeing the array.
+ */
+list_t *scene_neighbor_list(scene_neighbors_t neighbors, size_t count) {
+  list_t *list = list_init(count > 0 ? count : 1, free);
+  for (size_t i = 0; i < count; i++) {
+    scene_neighbor_t *neighbor = malloc(sizeof(scene_neighbor_t));
+    assert(neighbor);
+    *neighbor = neighbors.neighbors[i];
+    list_add(list, neighbor);
+  }
+  free(neighbors.neighbors);
+  return list;
+}
+
+list_t *scene_query_radius(scene_t *scene, vector_t center, double radius,
+                           body_type_t type) {
+  scene_neighbors_t neighbors =
+      scene_find_neighbors(scene, center, radius, type);
+  return scene_neighbor_list(neighbors, neighbors.count);
+}
+
+list_t *scene_query_nearest(scene_t *scene, vector_t center, size_t k,
+                            body_type_t type) {
+  // the k nearest bodies are within any radius that holds k bodies; once
+  // the search has covered every body, the rest are all that is left
+  double radius = NEAREST_INITIAL_RADIUS;
+  scene_neighbors_t neighbors =
+      scene_find_neighbors(scene, center, radius, type);
+  while (neighbors.count < k && radius != INFINITY) {
+    free(neighbors.neighbors);
+    radius = neighbors.complete ? INFINITY : 2 * radius;
+    neighbors = scene_find_neighbors(scene, center, radius, type);
+  }
+  return scene_neighbor_list(neighbors,
+                             neighbors.count < k ? neighbors.count : k);
 }
 
 size_t scene_get_width(scene_t *scene) { return scene->width; }
@@ -303,6 +303,30 @@ void sdl_draw_sprite(body_t *sprite) {
   free(rect);
 }
 
+void sdl_draw_projectiles(projectile_pool_t *pool) {
+  SDL_Texture *texture = projectile_pool_get_texture(pool);
+  if (texture == NULL) {
+    return;
+  }
+  double radius = projectile_pool_get_radius(pool);
+  vector_t window_center = get_window_center();
+  for (size_t i = 0; i < projectile_pool_size(pool); i++) {
+    if (!projectile_pool_is_alive(pool, i)) {
+      continue;
+    }
+    vector_t position = projectile_pool_get_position(pool, i);
+    vector_t min_pixel = get_window_position(
+        vec_add(position, (vector_t){-radius, radius}), window_center);
+    vector_t max_pixel = get_window_position(
+        vec_add(position, (vector_t){radius, -radius}), window_center);
+    SDL_Rect rect = {.x = min_pixel.x,
+                     .y = min_pixel.y,
+                     .w = max_pixel.x - min_pixel.x,
+                     .h = max_pixel.y - min_pixel.y};
+    SDL_RenderCopy(renderer, texture, NULL, &rect);
+  }
+}
+
 void sdl_show() {
   // Draw boundary lines
   vector_t window_center = get_window_center();
@@ -335,6 +359,12 @@ void sdl_render_scene(scene_t *scene) {
       list_free(shape);
     }
   }
+  for (body_type_t type = 0; type < BODY_TYPE_COUNT; type++) {
+    projectile_pool_t *pool = scene_get_projectiles(scene, type);
+    if (pool != NULL) {
+      sdl_draw_projectiles(pool);
+    }
+  }
   size_t text_count = scene_texts(scene);
   for (size_t i = 0; i < text_count; i++) {
     text_t *text = scene_get_text(scene, i);
@@ -0,0 +1,312 @@
+#include "spring_network.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t SPRING_NETWORK_INITIAL_CAPACITY = 16;
+// marks a removed body while renumbering the rest
+const size_t SPRING_NETWORK_REMOVED = SIZE_MAX;
+
+typedef struct {
+  size_t index1;
+  size_t index2;
+  double k;
+  double rest_length;
+  double damping;
+} spring_t;
+
+struct spring_network {
+  body_t **bodies;
+  size_t body_count;
+  size_t body_capacity;
+  // the springs in the order they were added
+  spring_t *springs;
+  size_t spring_count;
+  size_t spring_capacity;
+
+  // the springs as compressed sparse rows: the springs of body i (those
+  // whose other body has a higher index) are at row_start[i] up to
+  // row_start[i + 1] in the other arrays; rebuilt when the springs change
+  bool rows_dirty;
+  size_t *row_start;
+  size_t *column;
+  double *k;
+  double *rest_length;
+  double *damping;
+  size_t row_capacity;
+  size_t column_capacity;
+
+  // the bodies' state for the current tick, as parallel arrays
+  double *x;
+  double *y;
+  double *velocity_x;
+  double *velocity_y;
+  double *force_x;
+  double *force_y;
+  size_t state_capacity;
+};
+
+spring_network_t *spring_network_init(void) {
+  spring_network_t *network = malloc(sizeof(spring_network_t));
+  assert(network);
+  network->body_capacity = SPRING_NETWORK_INITIAL_CAPACITY;
+  network->bodies = malloc(network->body_capacity * sizeof(body_t *));
+  assert(network->bodies);
+  network->body_count = 0;
+  network->spring_capacity = SPRING_NETWORK_INITIAL_CAPACITY;
+  network->springs = malloc(network->spring_capacity * sizeof(spring_t));
+  assert(network->springs);
+  network->spring_count = 0;
+
+  network->rows_dirty = true;
+  network->row_start = NULL;
+  network->column = NULL;
+  network->k = NULL;
+  network->rest_length = NULL;
+  network->damping = NULL;
+  network->row_capacity = 0;
+  network->column_capacity = 0;
+
+  network->x = NULL;
+  network->y = NULL;
+  network->velocity_x = NULL;
+  network->velocity_y = NULL;
+  network->force_x = NULL;
+  network->force_y = NULL;
+  network->state_capacity = 0;
+  return network;
+}
+
+void spring_network_free(spring_network_t *network) {
+  free(network->bodies);
+  free(network->springs);
+  free(network->row_start);
+  free(network->column);
+  free(network->k);
+  free(network->rest_length);
+  free(network->damping);
+  free(network->x);
+  free(network->y);
+  free(network->velocity_x);
+  free(network->velocity_y);
+  free(network->force_x);
+  free(network->force_y);
+  free(network);
+}
+
+size_t spring_network_add_body(spring_network_t *network, body_t *body) {
+  if (network->body_count == network->body_capacity) {
+    network->body_capacity *= 2;
+    network->bodies = realloc(network->bodies,
+                              network->body_capacity * sizeof(body_t *));
+    assert(network->bodies);
+  }
+  network->bodies[network->body_count] = body;
+  network->rows_dirty = true;
+  return network->body_count++;
+}
+
+void spring_network_add_spring(spring_network_t *network, size_t index1,
+                               size_t index2, double k, double rest_length,
+                               double damping) {
+  assert(index1 < network->body_count && index2 < network->body_count);
+  assert(index1 != index2);
+  if (network->spring_count == network->spring_capacity) {
+    network->spring_capacity *= 2;
+    network->springs = realloc(network->springs,
+                               network->spring_capacity * sizeof(spring_t));
+    assert(network->springs);
+  }
+  network->springs[network->spring_count++] =
+      (spring_t){index1, index2, k, rest_length, damping};
+  network->rows_dirty = true;
+}
+
+size_t spring_network_bodies(spring_network_t *network) {
+  return network->body_count;
+}
+
+size_t spring_network_springs(spring_network_t *network) {
+  return network->spring_count;
+}
+
+void spring_network_remove_dead(spring_network_t *network) {
+  bool any_removed = false;
+  for (size_t i = 0; i < network->body_count && !any_removed; i++) {
+    any_removed = body_is_removed(network->bodies[i]);
+  }
+  if (!any_removed) {
+    return;
+  }
+
+  // renumber the bodies that are left, keeping them in order
+  size_t *new_index = malloc(network->body_count * sizeof(size_t));
+  assert(new_index);
+  size_t kept = 0;
+  for (size_t i = 0; i < network->body_count; i++) {
+    if (body_is_removed(network->bodies[i])) {
+      new_index[i] = SPRING_NETWORK_REMOVED;
+      continue;
+    }
+    new_index[i] = kept;
+    network->bodies[kept++] = network->bodies[i];
+  }
+  network->body_count = kept;
+
+  kept = 0;
+  for (size_t i = 0; i < network->spring_count; i++) {
+    spring_t spring = network->springs[i];
+    spring.index1 = new_index[spring.index1];
+    spring.index2 = new_index[spring.index2];
+    if (spring.index1 != SPRING_NETWORK_REMOVED &&
+        spring.index2 != SPRING_NETWORK_REMOVED) {
+      network->springs[kept++] = spring;
+    }
+  }
+  network->spring_count = kept;
+  network->rows_dirty = true;
+  free(new_index);
+}
+
+/**
+ * Makes sure the rows and the per-body arrays fit every body and spring.
+ */
+void spring_network_reserve(spring_network_t *network) {
+  if (network->row_capacity < network->body_count + 1) {
+    network->row_capacity = network->body_capacity + 1;
+    network->row_start = realloc(network->row_start,
+                                 network->row_capacity * sizeof(size_t));
+    assert(network->row_start);
+  }
+  if (network->column_capacity < network->spring_count) {
+    network->column_capacity = network->spring_capacity;
+    size_t capacity = network->column_capacity;
+    network->column = realloc(network->column, capacity * sizeof(size_t));
+    assert(network->column);
+    network->k = realloc(network->k, capacity * sizeof(double));
+    assert(network->k);
+    network->rest_length =
+        realloc(network->rest_length, capacity * sizeof(double));
+    assert(network->rest_length);
+    network->damping = realloc(network->damping, capacity * sizeof(double));
+    assert(network->damping);
+  }
+  if (network->state_capacity < network->body_count) {
+    network->state_capacity = network->body_capacity;
+    size_t size = network->state_capacity * sizeof(double);
+    network->x = realloc(network->x, size);
+    assert(network->x);
+    network->y = realloc(network->y, size);
+    assert(network->y);
+    network->velocity_x = realloc(network->velocity_x, size);
+    assert(network->velocity_x);
+    network->velocity_y = realloc(network->velocity_y, size);
+    assert(network->velocity_y);
+    network->force_x = realloc(network->force_x, size);
+    assert(network->force_x);
+    network->force_y = realloc(network->force_y, size);
+    assert(network->force_y);
+  }
+}
+
+/**
+ * Sorts the springs into rows by their lower-numbered body, keeping the
+ * order they were added within each row.
+ */
+void spring_network_build_rows(spring_network_t *network) {
+  size_t *row_start = network->row_start;
+  for (size_t i = 0; i <= network->body_count; i++) {
+    row_start[i] = 0;
+  }
+  // count the springs in each row, then sum the counts into the row starts
+  for (size_t i = 0; i < network->spring_count; i++) {
+    spring_t *spring = &network->springs[i];
+    size_t row = spring->index1 < spring->index2 ? spring->index1
+                                                 : spring->index2;
+    row_start[row + 1]++;
+  }
+  for (size_t i = 0; i < network->body_count; i++) {
+    row_start[i + 1] += row_start[i];
+  }
+  // fill each row, using its start as a cursor, which leaves each start at
+  // the end of its row; then shift the starts back up a row
+  for (size_t i = 0; i < network->spring_count; i++) {
+    spring_t *spring = &network->springs[i];
+    bool ordered = spring->index1 < spring->index2;
+    size_t row = ordered ? spring->index1 : spring->index2;
+    size_t slot = row_start[row]++;
+    network->column[slot] = ordered ? spring->index2 : spring->index1;
+    network->k[slot] = spring->k;
+    network->rest_length[slot] = spring->rest_length;
+    network->damping[slot] = spring->damping;
+  }
+  for (size_t i = network->body_count; i > 0; i--) {
+    row_start[i] = row_start[i - 1];
+  }
+  row_start[0] = 0;
+  network->rows_dirty = false;
+}
+
+void spring_network_apply(spring_network_t *network) {
+  if (network->spring_count == 0) {
+    return;
+  }
+  spring_network_reserve(network);
+  if (network->rows_dirty) {
+    spring_network_build_rows(network);
+  }
+
+  for (size_t i = 0; i < network->body_count; i++) {
+    body_t *body = network->bodies[i];
+    vector_t centroid = body_get_centroid(body);
+    vector_t velocity = body_get_velocity(body);
+    network->x[i] = centroid.x;
+    network->y[i] = centroid.y;
+    network->velocity_x[i] = velocity.x;
+    network->velocity_y[i] = velocity.y;
+    network->force_x[i] = 0;
+    network->force_y[i] = 0;
+  }
+
+  const double *x = network->x;
+  const double *y = network->y;
+  const double *velocity_x = network->velocity_x;
+  const double *velocity_y = network->velocity_y;
+  double *force_x = network->force_x;
+  double *force_y = network->force_y;
+  for (size_t i = 0; i < network->body_count; i++) {
+    double row_force_x = 0;
+    double row_force_y = 0;
+    for (size_t s = network->row_start[i]; s < network->row_start[i + 1];
+         s++) {
+      size_t j = network->column[s];
+      double dx = x[j] - x[i];
+      double dy = y[j] - y[i];
+      double distance = sqrt(dx * dx + dy * dy);
+      if (distance == 0) {
+        // the spring has no direction to pull in
+        continue;
+      }
+      double ux = dx / distance;
+      double uy = dy / distance;
+      double stretch_rate =
+          (velocity_x[j] - velocity_x[i]) * ux +
+          (velocity_y[j] - velocity_y[i]) * uy;
+      double magnitude = network->k[s] * (distance - network->rest_length[s]) +
+                         network->damping[s] * stretch_rate;
+      row_force_x += magnitude * ux;
+      row_force_y += magnitude * uy;
+      force_x[j] -= magnitude * ux;
+      force_y[j] -= magnitude * uy;
+    }
+    force_x[i] += row_force_x;
+    force_y[i] += row_force_y;
+  }
+
+  for (size_t i = 0; i < network->body_count; i++) {
+    body_add_force(network->bodies[i],
+                   (vector_t){network->force_x[i], network->force_y[i]});
+  }
+}
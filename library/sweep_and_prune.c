@@ -0,0 +1,282 @@
+#include "sweep_and_prune.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t SWEEP_INITIAL_CAPACITY = 16;
+const size_t SWEEP_NULL = SIZE_MAX;
+// boxes wider than this (e.g. a level's background) are kept out of the
+// bound on widths that queries search with, and are checked one by one
+const double SWEEP_WIDE_WIDTH = 512;
+
+typedef struct {
+  aabb_t aabb;
+  void *data;
+  // SWEEP_NULL once the entry is removed, until the entries are compacted
+  size_t proxy;
+} sweep_entry_t;
+
+struct sweep_and_prune {
+  // the proxies' boxes, sorted by min.x whenever sorted is true
+  sweep_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  bool sorted;
+  // the number of removed entries still in entries
+  size_t removed;
+  // at least the width of every entry's box that is not wide, so that a
+  // query can skip the entries that end before it starts
+  double max_width;
+  // the proxies of the wide entries, rebuilt when the entries are compacted
+  size_t *wide;
+  size_t wide_count;
+  size_t wide_capacity;
+  // the index in entries of each proxy, or the next free proxy if unused
+  size_t *positions;
+  size_t positions_capacity;
+  size_t free_proxy;
+  double margin;
+};
+
+sweep_and_prune_t *sweep_and_prune_init(double margin) {
+  sweep_and_prune_t *sap = malloc(sizeof(sweep_and_prune_t));
+  assert(sap);
+  sap->capacity = SWEEP_INITIAL_CAPACITY;
+  sap->entries = malloc(sap->capacity * sizeof(sweep_entry_t));
+  assert(sap->entries);
+  sap->count = 0;
+  sap->sorted = true;
+  sap->removed = 0;
+  sap->max_width = 0;
+  sap->wide = NULL;
+  sap->wide_count = 0;
+  sap->wide_capacity = 0;
+  sap->positions_capacity = 0;
+  sap->positions = NULL;
+  sap->free_proxy = SWEEP_NULL;
+  sap->margin = margin;
+  return sap;
+}
+
+void sweep_and_prune_free(sweep_and_prune_t *sap) {
+  free(sap->entries);
+  free(sap->wide);
+  free(sap->positions);
+  free(sap);
+}
+
+/**
+ * Checks whether a box is too wide to be found through the sorted entries.
+ */
+bool sweep_is_wide(aabb_t aabb) {
+  return aabb.max.x - aabb.min.x > SWEEP_WIDE_WIDTH;
+}
+
+/**
+ * Widens the bound on the entries' widths to cover a box that is not wide.
+ */
+void sweep_cover_width(sweep_and_prune_t *sap, aabb_t aabb) {
+  double width = aabb.max.x - aabb.min.x;
+  if (!sweep_is_wide(aabb) && width > sap->max_width) {
+    sap->max_width = width;
+  }
+}
+
+/**
+ * Adds a proxy to the list of wide entries.
+ */
+void sweep_add_wide(sweep_and_prune_t *sap, size_t proxy) {
+  if (sap->wide_count == sap->wide_capacity) {
+    sap->wide_capacity = sap->wide_capacity == 0 ? SWEEP_INITIAL_CAPACITY
+                                                 : 2 * sap->wide_capacity;
+    sap->wide = realloc(sap->wide, sap->wide_capacity * sizeof(size_t));
+    assert(sap->wide);
+  }
+  sap->wide[sap->wide_count++] = proxy;
+}
+
+/**
+ * Takes a proxy off the free list, growing the proxy table if it is empty.
+ */
+size_t sweep_allocate_proxy(sweep_and_prune_t *sap) {
+  if (sap->free_proxy == SWEEP_NULL) {
+    size_t old_capacity = sap->positions_capacity;
+    sap->positions_capacity =
+        old_capacity == 0 ? SWEEP_INITIAL_CAPACITY : 2 * old_capacity;
+    sap->positions =
+        realloc(sap->positions, sap->positions_capacity * sizeof(size_t));
+    assert(sap->positions);
+    for (size_t i = old_capacity; i < sap->positions_capacity; i++) {
+      sap->positions[i] = i + 1 < sap->positions_capacity ? i + 1 : SWEEP_NULL;
+    }
+    sap->free_proxy = old_capacity;
+  }
+  size_t proxy = sap->free_proxy;
+  sap->free_proxy = sap->positions[proxy];
+  return proxy;
+}
+
+size_t sweep_and_prune_insert(sweep_and_prune_t *sap, aabb_t aabb,
+                              void *data) {
+  if (sap->count == sap->capacity) {
+    sap->capacity *= 2;
+    sap->entries = realloc(sap->entries, sap->capacity * sizeof(sweep_entry_t));
+    assert(sap->entries);
+  }
+  size_t proxy = sweep_allocate_proxy(sap);
+  sweep_entry_t *entry = &sap->entries[sap->count];
+  entry->aabb = aabb_expand(aabb, sap->margin, VEC_ZERO);
+  entry->data = data;
+  entry->proxy = proxy;
+  sap->positions[proxy] = sap->count;
+  sap->count++;
+  sap->sorted = false;
+  sweep_cover_width(sap, entry->aabb);
+  return proxy;
+}
+
+void sweep_and_prune_remove(sweep_and_prune_t *sap, size_t proxy) {
+  assert(proxy < sap->positions_capacity);
+  // leave a hole, so that removing many bodies at once costs one pass to
+  // compact the entries (see sweep_sort()) instead of one per body
+  sap->entries[sap->positions[proxy]].proxy = SWEEP_NULL;
+  sap->removed++;
+  sap->positions[proxy] = sap->free_proxy;
+  sap->free_proxy = proxy;
+}
+
+bool sweep_and_prune_move(sweep_and_prune_t *sap, size_t proxy, aabb_t aabb,
+                          vector_t displacement) {
+  assert(proxy < sap->positions_capacity);
+  sweep_entry_t *entry = &sap->entries[sap->positions[proxy]];
+  if (aabb_contains(entry->aabb, aabb)) {
+    return false;
+  }
+  entry->aabb = aabb_expand(aabb, sap->margin, displacement);
+  sap->sorted = false;
+  sweep_cover_width(sap, entry->aabb);
+  return true;
+}
+
+aabb_t sweep_and_prune_get_fat_aabb(sweep_and_prune_t *sap, size_t proxy) {
+  assert(proxy < sap->positions_capacity);
+  return sap->entries[sap->positions[proxy]].aabb;
+}
+
+/**
+ * Drops the removed entries, keeping the others in order, tightens the
+ * bound on their widths and collects the wide ones.
+ */
+void sweep_compact(sweep_and_prune_t *sap) {
+  size_t kept = 0;
+  sap->max_width = 0;
+  sap->wide_count = 0;
+  for (size_t i = 0; i < sap->count; i++) {
+    sweep_entry_t *entry = &sap->entries[i];
+    if (entry->proxy == SWEEP_NULL) {
+      continue;
+    }
+    sweep_cover_width(sap, entry->aabb);
+    if (sweep_is_wide(entry->aabb)) {
+      sweep_add_wide(sap, entry->proxy);
+    }
+    if (kept != i) {
+      sap->entries[kept] = *entry;
+      sap->positions[entry->proxy] = kept;
+    }
+    kept++;
+  }
+  sap->count = kept;
+  sap->removed = 0;
+}
+
+/**
+ * Compacts the entries, then insertion sorts them by min.x.
+ * Each entry only moves past the entries it overtook since the last sort.
+ */
+void sweep_sort(sweep_and_prune_t *sap) {
+  if (sap->sorted && sap->removed == 0) {
+    return;
+  }
+  sweep_compact(sap);
+  if (sap->sorted) {
+    return;
+  }
+  for (size_t i = 1; i < sap->count; i++) {
+    sweep_entry_t entry = sap->entries[i];
+    size_t j = i;
+    while (j > 0 && sap->entries[j - 1].aabb.min.x > entry.aabb.min.x) {
+      sap->entries[j] = sap->entries[j - 1];
+      sap->positions[sap->entries[j].proxy] = j;
+      j--;
+    }
+    if (j != i) {
+      sap->entries[j] = entry;
+      sap->positions[entry.proxy] = j;
+    }
+  }
+  sap->sorted = true;
+}
+
+void sweep_and_prune_find_pairs(sweep_and_prune_t *sap, sweep_pair_t callback,
+                                void *aux) {
+  sweep_sort(sap);
+  for (size_t i = 0; i < sap->count; i++) {
+    sweep_entry_t *entry = &sap->entries[i];
+    // every later entry that starts before this one ends overlaps it in x
+    for (size_t j = i + 1;
+         j < sap->count && sap->entries[j].aabb.min.x < entry->aabb.max.x;
+         j++) {
+      sweep_entry_t *other = &sap->entries[j];
+      if (entry->aabb.min.y < other->aabb.max.y &&
+          other->aabb.min.y < entry->aabb.max.y) {
+        callback(entry->data, other->data, aux);
+      }
+    }
+  }
+}
+
+void sweep_and_prune_query(sweep_and_prune_t *sap, aabb_t aabb,
+                           aabb_query_t callback, void *aux) {
+  sweep_sort(sap);
+  for (size_t i = 0; i < sap->wide_count; i++) {
+    sweep_entry_t *entry = &sap->entries[sap->positions[sap->wide[i]]];
+    if (aabb_overlap(entry->aabb, aabb) &&
+        !callback(entry->proxy, entry->data, aux)) {
+      return;
+    }
+  }
+
+  // no entry starting before this can reach the box, apart from the wide
+  // ones, which were checked above
+  double start = aabb.min.x - sap->max_width;
+  size_t low = 0;
+  size_t high = sap->count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (sap->entries[middle].aabb.min.x < start) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (size_t i = low;
+       i < sap->count && sap->entries[i].aabb.min.x < aabb.max.x; i++) {
+    sweep_entry_t *entry = &sap->entries[i];
+    if (!sweep_is_wide(entry->aabb) && aabb_overlap(entry->aabb, aabb) &&
+        !callback(entry->proxy, entry->data, aux)) {
+      return;
+    }
+  }
+}
+
+void sweep_and_prune_for_each(sweep_and_prune_t *sap, aabb_query_t callback,
+                              void *aux) {
+  for (size_t i = 0; i < sap->count; i++) {
+    sweep_entry_t *entry = &sap->entries[i];
+    if (entry->proxy != SWEEP_NULL &&
+        !callback(entry->proxy, entry->data, aux)) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,242 @@
+#include "timer_wheel.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t TIMER_INITIAL_CAPACITY = 16;
+// each level has 2 ^ TIMER_SLOT_BITS slots
+const size_t TIMER_SLOT_BITS = 6;
+const size_t TIMER_SLOT_COUNT = (size_t)1 << 6;
+// at 60 ticks per second, 4 levels of 64 slots cover over 77 hours; later
+// timers wait in the last slot of the top level until they fit
+const size_t TIMER_LEVEL_COUNT = 4;
+// marks the end of a list of timers, and timers that are not waiting
+const size_t TIMER_NONE = SIZE_MAX;
+const double TIMER_ROUNDING = 1e-9;
+
+typedef struct {
+  timer_callback_t callback;
+  body_t *body;
+  void *aux;
+  // the tick the timer goes off on
+  size_t deadline;
+  // increases each time the node is released, so old handles go stale
+  size_t generation;
+  // the slot the timer waits in, or TIMER_NONE if the node is free
+  size_t slot;
+  // the timers before and after this one in its slot; next also links the
+  // free nodes together
+  size_t prev;
+  size_t next;
+} timer_node_t;
+
+struct timer_wheel {
+  double resolution;
+  // the seconds since the last tick
+  double accumulated;
+  // the number of ticks so far
+  size_t now;
+  timer_node_t *nodes;
+  size_t capacity;
+  size_t free_list;
+  size_t count;
+  // the first timer in each slot, level by level
+  size_t *heads;
+};
+
+/**
+ * Links the nodes from start up to the capacity into the free list.
+ */
+void timer_wheel_add_free(timer_wheel_t *wheel, size_t start) {
+  for (size_t i = wheel->capacity; i > start; i--) {
+    timer_node_t *node = &wheel->nodes[i - 1];
+    node->slot = TIMER_NONE;
+    node->next = wheel->free_list;
+    wheel->free_list = i - 1;
+  }
+}
+
+timer_wheel_t *timer_wheel_init(double resolution) {
+  assert(resolution > 0);
+  timer_wheel_t *wheel = malloc(sizeof(timer_wheel_t));
+  assert(wheel);
+  wheel->resolution = resolution;
+  wheel->accumulated = 0;
+  wheel->now = 0;
+  wheel->capacity = TIMER_INITIAL_CAPACITY;
+  wheel->nodes = calloc(wheel->capacity, sizeof(timer_node_t));
+  assert(wheel->nodes);
+  wheel->free_list = TIMER_NONE;
+  timer_wheel_add_free(wheel, 0);
+  wheel->count = 0;
+  wheel->heads = malloc(TIMER_LEVEL_COUNT * TIMER_SLOT_COUNT * sizeof(size_t));
+  assert(wheel->heads);
+  for (size_t i = 0; i < TIMER_LEVEL_COUNT * TIMER_SLOT_COUNT; i++) {
+    wheel->heads[i] = TIMER_NONE;
+  }
+  return wheel;
+}
+
+void timer_wheel_free(timer_wheel_t *wheel) {
+  free(wheel->nodes);
+  free(wheel->heads);
+  free(wheel);
+}
+
+size_t timer_wheel_size(timer_wheel_t *wheel) { return wheel->count; }
+
+/**
+ * Puts a timer in the slot of the lowest level its deadline fits in.
+ */
+void timer_wheel_insert(timer_wheel_t *wheel, size_t index) {
+  timer_node_t *node = &wheel->nodes[index];
+  size_t delta = node->deadline - wheel->now;
+  size_t mask = TIMER_SLOT_COUNT - 1;
+  size_t level = 0;
+  while (level < TIMER_LEVEL_COUNT &&
+         delta >> (TIMER_SLOT_BITS * (level + 1)) != 0) {
+    level++;
+  }
+  size_t slot;
+  if (level < TIMER_LEVEL_COUNT) {
+    slot = (node->deadline >> (TIMER_SLOT_BITS * level)) & mask;
+  } else {
+    // too far off for the wheel: wait in the last slot to be reached
+    level = TIMER_LEVEL_COUNT - 1;
+    slot = ((wheel->now >> (TIMER_SLOT_BITS * level)) + mask) & mask;
+  }
+  slot += level * TIMER_SLOT_COUNT;
+
+  node->slot = slot;
+  node->prev = TIMER_NONE;
+  node->next = wheel->heads[slot];
+  if (node->next != TIMER_NONE) {
+    wheel->nodes[node->next].prev = index;
+  }
+  wheel->heads[slot] = index;
+}
+
+/**
+ * Takes a timer out of its slot.
+ */
+void timer_wheel_unlink(timer_wheel_t *wheel, size_t index) {
+  timer_node_t *node = &wheel->nodes[index];
+  if (node->prev == TIMER_NONE) {
+    wheel->heads[node->slot] = node->next;
+  } else {
+    wheel->nodes[node->prev].next = node->next;
+  }
+  if (node->next != TIMER_NONE) {
+    wheel->nodes[node->next].prev = node->prev;
+  }
+}
+
+/**
+ * Returns an unlinked timer's node to the free list.
+ */
+void timer_wheel_release(timer_wheel_t *wheel, size_t index) {
+  timer_node_t *node = &wheel->nodes[index];
+  node->generation++;
+  node->slot = TIMER_NONE;
+  node->next = wheel->free_list;
+  wheel->free_list = index;
+  wheel->count--;
+}
+
+timer_handle_t timer_wheel_schedule(timer_wheel_t *wheel, double delay,
+                                    timer_callback_t callback, body_t *body,
+                                    void *aux) {
+  if (wheel->free_list == TIMER_NONE) {
+    size_t old_capacity = wheel->capacity;
+    wheel->capacity *= 2;
+    wheel->nodes =
+        realloc(wheel->nodes, wheel->capacity * sizeof(timer_node_t));
+    assert(wheel->nodes);
+    for (size_t i = old_capacity; i < wheel->capacity; i++) {
+      wheel->nodes[i].generation = 0;
+    }
+    timer_wheel_add_free(wheel, old_capacity);
+  }
+  size_t index = wheel->free_list;
+  timer_node_t *node = &wheel->nodes[index];
+  wheel->free_list = node->next;
+  wheel->count++;
+
+  // count the time already accumulated towards the next tick, and let delays
+  // of a whole number of ticks round down
+  double ticks = ceil((delay + wheel->accumulated) / wheel->resolution -
+                      TIMER_ROUNDING);
+  size_t wait = ticks < 1 ? 1 : ticks >= SIZE_MAX / 2 ? SIZE_MAX / 2
+                                                      : (size_t)ticks;
+  node->callback = callback;
+  node->body = body;
+  node->aux = aux;
+  node->deadline = wheel->now + wait;
+  timer_wheel_insert(wheel, index);
+  return (timer_handle_t){index, node->generation};
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_handle_t handle) {
+  if (handle.index >= wheel->capacity) {
+    return;
+  }
+  timer_node_t *node = &wheel->nodes[handle.index];
+  if (node->generation != handle.generation || node->slot == TIMER_NONE) {
+    return;
+  }
+  timer_wheel_unlink(wheel, handle.index);
+  timer_wheel_release(wheel, handle.index);
+}
+
+/**
+ * Moves every timer in a slot down to the level its deadline now fits in.
+ */
+void timer_wheel_cascade(timer_wheel_t *wheel, size_t slot) {
+  size_t index = wheel->heads[slot];
+  wheel->heads[slot] = TIMER_NONE;
+  while (index != TIMER_NONE) {
+    size_t next = wheel->nodes[index].next;
+    timer_wheel_insert(wheel, index);
+    index = next;
+  }
+}
+
+/**
+ * Advances the wheel by one tick, firing the timers due on it.
+ */
+void timer_wheel_step(timer_wheel_t *wheel) {
+  wheel->now++;
+  size_t mask = TIMER_SLOT_COUNT - 1;
+  // each time a level comes round to its first slot, the next level's
+  // current slot has come within reach of it
+  for (size_t level = 1; level < TIMER_LEVEL_COUNT; level++) {
+    size_t shift = TIMER_SLOT_BITS * level;
+    if ((wheel->now & (((size_t)1 << shift) - 1)) != 0) {
+      break;
+    }
+    size_t slot = (wheel->now >> shift) & mask;
+    timer_wheel_cascade(wheel, level * TIMER_SLOT_COUNT + slot);
+  }
+
+  // callbacks only schedule timers at least a tick later, never in this slot
+  size_t slot = wheel->now & mask;
+  while (wheel->heads[slot] != TIMER_NONE) {
+    size_t index = wheel->heads[slot];
+    timer_node_t *node = &wheel->nodes[index];
+    timer_callback_t callback = node->callback;
+    body_t *body = node->body;
+    void *aux = node->aux;
+    timer_wheel_unlink(wheel, index);
+    timer_wheel_release(wheel, index);
+    callback(body, aux);
+  }
+}
+
+void timer_wheel_advance(timer_wheel_t *wheel, double dt) {
+  wheel->accumulated += dt;
+  while (wheel->accumulated >= wheel->resolution) {
+    wheel->accumulated -= wheel->resolution;
+    timer_wheel_step(wheel);
+  }
+}